@@ -0,0 +1,209 @@
+#include "DriverBenchmark.h"
+#include <Wire.h>
+
+#include "utility/MPU6886.h"
+#include "utility/bmm150.h"
+#include "utility/MAX30102.h"
+#include "utility/FT6336U.h"
+#include "utility/tcs34725_driver.h"
+#include "utility/bh1750fvi_driver.h"
+#include "utility/sgp30.h"
+#include "utility/PAJ7620.h"
+
+#define FT6336U_SDA         21
+#define FT6336U_SCL         22
+#define FT6336U_RST         38
+#define FT6336U_INT         37
+
+static I2C_MPU6886 imu;
+static BMM150 mag;
+static MAX30102 ppg;
+static FT6336U ctp(FT6336U_SDA, FT6336U_SCL, FT6336U_RST, FT6336U_INT);
+static TCS34725 color;
+static BH1750FVI light;
+static sgp30 gas;
+static PAJ7620 gesture;
+
+static bool imuStarted = false;
+
+static bool setupImu(void) {
+  if (!imuStarted)
+    imuStarted = imu.begin() == 0;
+  return imuStarted;
+}
+
+static uint16_t readAccel(void) {
+  float ax, ay, az;
+
+  imu.getAccel(&ax, &ay, &az);
+  return 1;
+}
+
+static uint16_t readGyro(void) {
+  float gx, gy, gz;
+
+  imu.getGyro(&gx, &gy, &gz);
+  return 1;
+}
+
+static bool setupMag(void) {
+  return mag.initialize() == BMM150_OK;
+}
+
+static uint16_t readMag(void) {
+  mag.read_mag_data();
+  return 1;
+}
+
+static bool setupPpg(void) {
+  if (!ppg.begin(Wire, I2C_SPEED_FAST))
+    return false;
+  ppg.setup();
+  return true;
+}
+
+static uint16_t readPpg(void) {
+  uint16_t n = ppg.check();
+
+  while (ppg.available())
+    ppg.nextSample();
+  return n;
+}
+
+static bool setupTouch(void) {
+  ctp.begin();
+  return true;
+}
+
+static uint16_t readTouch(void) {
+  ctp.scan();
+  return 1;
+}
+
+static bool setupColor(void) {
+  return color.begin();
+}
+
+static uint16_t readColor(void) {
+  uint16_t r, g, b, c;
+
+  color.getRawData(&r, &g, &b, &c);
+  return 1;
+}
+
+static bool setupLight(void) {
+  return true;
+}
+
+static uint16_t readLight(void) {
+  light.get_Data();
+  return 1;
+}
+
+static bool setupGas(void) {
+  return gas.SGP30_Init() == 0;
+}
+
+static uint16_t readGas(void) {
+  return gas.SGP30_Get_Value() == 0 ? 1 : 0;
+}
+
+static bool setupGesture(void) {
+  return gesture.paj7620Init() == 0;
+}
+
+static uint16_t readGesture(void) {
+  uint8_t flags0, flags1;
+
+  gesture.paj7620ReadReg(0x43, 1, &flags0);
+  gesture.paj7620ReadReg(0x44, 1, &flags1);
+  return 1;
+}
+
+const bench_case_t benchCases[] = {
+  { "MPU6886.getAccel",         200, setupImu,     readAccel },
+  { "MPU6886.getGyro",          200, setupImu,     readGyro },
+  { "BMM150.read_mag_data",     200, setupMag,     readMag },
+  { "MAX30102.check",           50,  setupPpg,     readPpg },
+  { "FT6336U.scan",             200, setupTouch,   readTouch },
+  { "TCS34725.getRawData",      50,  setupColor,   readColor },
+  { "BH1750FVI.get_Data",       5,   setupLight,   readLight },
+  { "SGP30.SGP30_Get_Value",    20,  setupGas,     readGas },
+  { "PAJ7620.gesture",          200, setupGesture, readGesture },
+};
+
+const uint8_t benchCaseCount = sizeof(benchCases) / sizeof(benchCases[0]);
+
+static void printPerSample(Print& out, const char* key, double total, uint32_t samples, bool valid) {
+  out.print(",\"");
+  out.print(key);
+  out.print("\":");
+  if (valid && samples)
+    out.print(total / samples, 2);
+  else
+    out.print("null");
+}
+
+static void runCase(Print& out, const bench_case_t* bench, bench_counters_fn counters, bench_feed_fn feed) {
+  bench_counters_t before, after;
+  uint64_t us = 0, cycles = 0;
+  uint32_t samples = 0;
+
+  //Setup first: some drivers print progress to Serial
+  bool started = bench->setup();
+
+  out.print("{\"bench\":\"");
+  out.print(bench->name);
+  out.print("\"");
+  if (!started) {
+    out.println(",\"skipped\":true}");
+    return;
+  }
+
+  if (feed)
+    feed(bench);
+  bench->read();
+
+  bool counted = counters && counters(&before);
+  for (uint16_t i = 0; i < bench->iterations; i++) {
+    if (feed)
+      feed(bench);
+    uint32_t startUs = micros();
+    uint32_t startCycles = ESP.getCycleCount();
+    samples += bench->read();
+    cycles += (uint32_t)(ESP.getCycleCount() - startCycles);
+    us += (uint32_t)(micros() - startUs);
+  }
+  //The counters span the feed calls too, so feeds must stay off the bus
+  counted = counted && counters(&after);
+
+  out.print(",\"iterations\":");
+  out.print((unsigned long)bench->iterations);
+  out.print(",\"samples\":");
+  out.print((unsigned long)samples);
+  printPerSample(out, "us_per_sample", (double)us, samples, true);
+  printPerSample(out, "cycles_per_sample", (double)cycles, samples, true);
+  printPerSample(out, "transactions_per_sample", after.transactions - before.transactions, samples, counted);
+  printPerSample(out, "bytes_per_sample", after.bytes - before.bytes, samples, counted);
+  printPerSample(out, "bus_us_per_sample", after.busUs - before.busUs, samples, counted);
+  out.println("}");
+}
+
+void benchRunAll(Print& out, const char* platform, const char* counterSource,
+                 bench_counters_fn counters, bench_feed_fn feed) {
+  bench_counters_t probe;
+
+  if (counters && !counters(&probe))
+    counters = NULL;
+
+  out.print("{\"suite\":\"Rubik_Cube.drivers\",\"format\":");
+  out.print(BENCH_FORMAT_VERSION);
+  out.print(",\"platform\":\"");
+  out.print(platform);
+  out.print("\",\"counters\":\"");
+  out.print(counters ? counterSource : "none");
+  out.println("\"}");
+
+  for (uint8_t i = 0; i < benchCaseCount; i++)
+    runCase(out, &benchCases[i], counters, feed);
+}
@@ -0,0 +1,54 @@
+#ifndef _DRIVER_BENCHMARK_H_
+#define _DRIVER_BENCHMARK_H_
+
+#include <Arduino.h>
+
+/*
+ * Per-sample cost of each driver's read path.
+ *
+ * Every case times `iterations` calls of one read, after one untimed warm-up
+ * call, and divides by the logical samples they produced. Results go out as
+ * JSON lines: one "suite" line, then one line per case (wrapped here):
+ *
+ *   {"bench":"MPU6886.getAccel","iterations":200,"samples":200,"us_per_sample":412.10,
+ *    "cycles_per_sample":98904.00,"transactions_per_sample":1.00,"bytes_per_sample":7.00,
+ *    "bus_us_per_sample":405.20}
+ *
+ * Lines not starting with '{' are drivers printing to Serial during setup.
+ *
+ * Times are wall time, so they include the wire and any conversion wait the
+ * driver does. The bus counters come from the platform: SimBus on the host,
+ * I2CBus::getStats() on the target (null unless built with I2C_BUS_STATS).
+ *
+ * Shared by DriverBenchmark.ino and extras/host_sim/examples/benchmark.cpp.
+ */
+
+#define BENCH_FORMAT_VERSION        1
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t bytes;                   //Written plus read
+  uint32_t busUs;
+} bench_counters_t;
+
+//Read the platform's running bus counters, false if there are none;
+//benchRunAll() then reports the per-sample bus figures as null
+typedef bool (*bench_counters_fn)(bench_counters_t* out);
+
+typedef struct bench_case {
+  const char* name;
+  uint16_t iterations;
+  bool (*setup)(void);              //Start the driver, false skips the case
+  uint16_t (*read)(void);           //One read, returns the samples it produced
+} bench_case_t;
+
+//Called before every timed read, e.g. to let a FIFO fill; not timed
+typedef void (*bench_feed_fn)(const bench_case_t* bench);
+
+extern const bench_case_t benchCases[];
+extern const uint8_t benchCaseCount;
+
+void benchRunAll(Print& out, const char* platform, const char* counterSource,
+                 bench_counters_fn counters, bench_feed_fn feed = NULL);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Driver read-path benchmark, see DriverBenchmark.h for the output format.
+ *
+ * Build with I2C_BUS_STATS defined (build flags or I2CStats.h) to also get
+ * transactions, bytes and bus time per sample. Sensors that are not fitted
+ * are reported as skipped.
+ */
+
+#include <Rubik_Cube.h>
+#include "DriverBenchmark.h"
+
+static bool readCounters(bench_counters_t* out) {
+  static i2c_stats_snapshot_t snapshot;
+
+  if (!I2CBus::get().getStats(&snapshot))
+    return false;
+  out->transactions = snapshot.total.transactions;
+  out->bytes = snapshot.total.bytesWritten + snapshot.total.bytesRead;
+  out->busUs = snapshot.total.totalUs;
+  return true;
+}
+
+static void feed(const bench_case_t* bench) {
+  //Let the MAX30102 FIFO collect a few samples between checks
+  if (strcmp(bench->name, "MAX30102.check") == 0)
+    delay(20);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  I2CBus::get().begin();
+
+  benchRunAll(Serial, "esp32", "i2cstats", readCounters, feed);
+}
+
+void loop() {
+}
@@ -0,0 +1,66 @@
+/*
+ * Host runner for examples/Benchmark/DriverBenchmark: the same cases against
+ * the simulated devices, bus figures from SimBus. Cycles are derived from
+ * host time at a nominal 240 MHz and only mean anything relative to each
+ * other.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+
+#include "DriverBenchmark.h"
+#include "SimBus.h"
+#include "SimModels.h"
+
+static SimMPU6886 simImu;
+static SimBMM150 simMag;
+static SimMAX30102 simPpg;
+static SimPAJ7620 simGesture;
+static SimFT6336U simTouch;
+static SimTCS34725 simColor;
+static SimBH1750 simLight;
+static SimSGP30 simGas;
+
+static bool readCounters(bench_counters_t* out) {
+  sim_bus_stats_t stats = SimBus::port(0).getStats();
+
+  out->transactions = stats.transactions;
+  out->bytes = stats.bytesWritten + stats.bytesRead;
+  out->busUs = stats.busTimeNs / 1000;
+  return true;
+}
+
+static void feed(const bench_case_t* bench) {
+  static uint32_t t = 0;
+
+  //Four new samples per check, as a 100 Hz sensor read every 40 ms would have
+  if (strcmp(bench->name, "MAX30102.check") == 0)
+    for (uint8_t i = 0; i < 4; i++, t++)
+      simPpg.pushSample(50000 + (t & 0xFF), 60000 + (t & 0xFF));
+}
+
+int main(int argc, char** argv) {
+  SimBus& bus = SimBus::port(0);
+
+  //--realtime: sleep for the modelled wire time as well
+  bus.setRealtime(argc > 1 && strcmp(argv[1], "--realtime") == 0);
+
+  bus.attach(&simImu);
+  bus.attach(&simMag);
+  bus.attach(&simPpg);
+  bus.attach(&simGesture);
+  bus.attach(&simTouch);
+  bus.attach(&simColor);
+  bus.attach(&simLight);
+  bus.attach(&simGas);
+
+  simImu.setMotion(100, -200, 8192, 5, -5, 0);
+  simMag.setRaw(400, -200, 1200, 6000);
+  simTouch.setTouches(1, 120, 200);
+  simColor.setRGBC(1000, 2000, 3000, 6500);
+  simLight.setLux(321.0f);
+  simGas.setAirQuality(612, 37);
+
+  benchRunAll(Serial, "host", "simbus", readCounters, feed);
+  return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * Runs every I2C driver of the library against the simulated devices and
+ * prints what it read back, plus the bus statistics.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "MPU6886.h"
+#include "bmm150.h"
+#include "MAX30102.h"
+#include "PAJ7620.h"
+#include "FT6336U.h"
+#include "tcs34725_driver.h"
+#include "bh1750fvi_driver.h"
+#include "sgp30.h"
+#include "Ip5306.h"
+#include "I2CBus.h"
+
+#include "SimBus.h"
+#include "SimModels.h"
+#include "SimPins.h"
+
+#define BMM150_DRDY_PIN     35
+#define MAX30102_INT_PIN    36
+
+static SimMPU6886 simImu;
+static SimBMM150 simMag;
+static SimMAX30102 simPpg;
+static SimPAJ7620 simGesture;
+static SimFT6336U simTouch;
+static SimTCS34725 simColor;
+static SimBH1750 simLight;
+static SimSGP30 simGas;
+static SimIP5306 simPower;
+
+static void demoMPU6886(void) {
+  I2C_MPU6886 imu;
+  float ax, ay, az, gx, gy, gz;
+  mpu6886_sample_t samples[8];
+
+  simImu.setMotion(0, 0, 8192, 131, -131, 0);
+  Serial.printf("MPU6886   begin=%d\n", imu.begin());
+  imu.getAccel(&ax, &ay, &az);
+  imu.getGyro(&gx, &gy, &gz);
+  Serial.printf("          accel %.3f %.3f %.3f g, gyro %.2f %.2f %.2f dps\n", ax, ay, az, gx, gy, gz);
+
+  imu.enableFIFO();
+  for (uint8_t i = 0; i < 5; i++)
+    simImu.pushFIFO();
+  uint16_t n = imu.readFIFO(samples, 8);
+  Serial.printf("          FIFO: %u frames, first az=%d\n", n, n ? samples[0].raw.az : 0);
+  imu.disableFIFO();
+}
+
+static void demoBMM150(void) {
+  BMM150 mag;
+  struct bmm150_sample sample;
+
+  simMag.setRaw(400, -200, 1200, 6000);
+  Serial.printf("BMM150    init=%d\n", mag.initialize());
+  Serial.printf("          forced=%d", mag.read_mag_data_forced());
+  Serial.printf(" -> %d %d %d uT\n", mag.mag_data.x, mag.mag_data.y, mag.mag_data.z);
+
+  simMag.setDrdyPin(BMM150_DRDY_PIN);
+  mag.start_stream(BMM150_DRDY_PIN);
+  for (uint8_t i = 0; i < 5; i++) {
+    simMag.convert();
+    delay(10);
+  }
+  mag.stop_stream();
+  uint32_t count = 0;
+  while (mag.read_sample(&sample))
+    count++;
+  Serial.printf("          DRDY stream: %u samples\n", count);
+}
+
+static void demoMAX30102(void) {
+  MAX30102 ppg;
+
+  Serial.printf("MAX30102  begin=%d\n", ppg.begin(Wire, I2C_SPEED_FAST));
+  ppg.setup();
+  for (uint32_t i = 0; i < 10; i++)
+    simPpg.pushSample(50000 + i, 60000 + i);
+  uint16_t n = ppg.check();
+  Serial.printf("          check: %u new, red=%u ir=%u\n", n, ppg.getFIFORed(), ppg.getFIFOIR());
+
+  //40 samples into a 32 deep FIFO: 8 are lost and show up in the overflow count
+  static SampleRing<max30102_sample_t, 64> ring;
+  max30102_sample_t head[8];
+  for (uint32_t i = 0; i < 40; i++)
+    simPpg.pushSample(70000 + i, 80000 + i);
+  uint16_t first = ppg.readSamples(head, 8);
+  uint16_t rest = ppg.readSamples(ring);
+  Serial.printf("          readSamples: %u + %u samples, first red=%u, overflow %u\n",
+                first, rest, head[0].red, ppg.getOverflowCount());
+
+  //A_FULL at 8 free slots: the reader task wakes once every 24 samples
+  simPpg.setIntPin(MAX30102_INT_PIN);
+  ppg.startStream(MAX30102_INT_PIN, 8);
+  uint32_t streamed = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    simPpg.pushSample(90000 + i, 95000 + i);
+    delay(1);
+    streamed += ppg.readStream(head, 8);
+  }
+  delay(5);
+  streamed += ppg.readStream(head, 8);
+  ppg.stopStream();
+  Serial.printf("          A_FULL stream: %u samples delivered, %u left in FIFO\n", streamed, simPpg.fifoLevel());
+  simPpg.setTemperature(31.25f);
+  Serial.printf("          die temperature %.2f C\n", ppg.readTemperature());
+}
+
+static void demoPAJ7620(void) {
+  PAJ7620 gesture;
+  uint8_t flags = 0;
+
+  Serial.printf("PAJ7620   init=%u\n", gesture.paj7620Init());
+  simGesture.setGesture(GES_RIGHT_FLAG);
+  gesture.paj7620ReadReg(0x43, 1, &flags);
+  Serial.printf("          gesture flags 0x%02X\n", flags);
+}
+
+static void demoFT6336U(void) {
+  FT6336U touch(-1, -1, 32, 39);
+
+  touch.begin();
+  simTouch.setTouches(2, 120, 200, 30, 40);
+  FT6336U_TouchPointType tp = touch.scan();
+  Serial.printf("FT6336U   %u touches, (%u,%u) (%u,%u)\n", tp.touch_count,
+                tp.tp[0].x, tp.tp[0].y, tp.tp[1].x, tp.tp[1].y);
+}
+
+static void demoTCS34725(void) {
+  TCS34725 color;
+  uint16_t r, g, b, c;
+
+  Serial.printf("TCS34725  begin=%d\n", color.begin());
+  simColor.setRGBC(1000, 2000, 3000, 6500);
+  color.getRawData(&r, &g, &b, &c);
+  Serial.printf("          r=%u g=%u b=%u c=%u\n", r, g, b, c);
+}
+
+static void demoBH1750(void) {
+  BH1750FVI light;
+
+  simLight.setLux(321.0f);
+  light.BH1750FVI_READ_DATA();
+  Serial.printf("BH1750    %.1f lx\n", light.get_Data());
+}
+
+static void demoSGP30(void) {
+  sgp30 gas;
+
+  simGas.setAirQuality(612, 37);
+  gas.SGP30_Init();
+  gas.SGP30_Get_Value();
+  Serial.printf("SGP30     co2eq=%u ppm tvoc=%u ppb\n", gas.get_co2_val(), gas.get_tvoc_val());
+}
+
+static void demoIP5306(void) {
+  IP5306 power;
+
+  simPower.setLevel(75);
+  simPower.setCharging(true);
+  Serial.printf("IP5306    level=%u%% charging=%u full=%u\n", power.Ip5306_Check_Power(),
+                power.Ip5306_Check_Charge(), power.Ip5306_Check_Full());
+}
+
+int main(void) {
+  SimBus& bus = SimBus::port(0);
+
+  bus.attach(&simImu);
+  bus.attach(&simMag);
+  bus.attach(&simPpg);
+  bus.attach(&simGesture);
+  bus.attach(&simTouch);
+  bus.attach(&simColor);
+  bus.attach(&simLight);
+  bus.attach(&simGas);
+  bus.attach(&simPower);
+
+  demoMPU6886();
+  demoBMM150();
+  demoMAX30102();
+  demoPAJ7620();
+  demoFT6336U();
+  demoTCS34725();
+  demoBH1750();
+  demoSGP30();
+  demoIP5306();
+
+  sim_bus_stats_t stats = bus.getStats();
+  Serial.printf("\nbus: %u transactions, %u bytes written, %u bytes read, %u NACKs, %.2f ms on the wire\n",
+                stats.transactions, stats.bytesWritten, stats.bytesRead, stats.nacks, stats.busTimeNs / 1e6);
+
+  //Driver side accounting, only with -DI2C_BUS_STATS
+  I2CBus::get().dumpStats(Serial);
+  return 0;
+}
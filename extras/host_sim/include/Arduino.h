@@ -0,0 +1,128 @@
+#ifndef _HOST_SIM_ARDUINO_H_
+#define _HOST_SIM_ARDUINO_H_
+
+/*
+ * Arduino-ESP32 stand-in for the host simulator. Time is wall-clock time,
+ * Serial goes to stdout, GPIO levels and interrupts are driven through
+ * sim/SimPins.h.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH                0x1
+#define LOW                 0x0
+
+#define INPUT               0x01
+#define OUTPUT              0x02
+#define INPUT_PULLUP        0x05
+#define INPUT_PULLDOWN      0x09
+
+#define RISING              0x01
+#define FALLING             0x02
+#define CHANGE              0x03
+
+#define DEC                 10
+#define HEX                 16
+#define OCT                 8
+#define BIN                 2
+
+#define PI                  3.1415926535897932384626433832795
+#define DEG_TO_RAD          0.017453292519943295769236907684886
+#define RAD_TO_DEG          57.295779513082320876798154814105
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define ESP_LOGE(tag, ...)  do { printf("E (%s) ", tag); printf(__VA_ARGS__); printf("\n"); } while (0)
+#define ESP_LOGW(tag, ...)  do { printf("W (%s) ", tag); printf(__VA_ARGS__); printf("\n"); } while (0)
+#define ESP_LOGI(tag, ...)  do {} while (0)
+#define ESP_LOGD(tag, ...)  do {} while (0)
+#define ESP_LOGV(tag, ...)  do {} while (0)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+
+using std::min;
+using std::max;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println(void) { return write("\r\n"); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int fmt) { size_t n = print(value, fmt); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__ ((format (printf, 2, 3)));
+};
+
+class Stream : public Print {
+  public:
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    virtual int peek(void) { return -1; }
+};
+
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end(void) {}
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+    int available(void) { return 0; }
+    int read(void) { return -1; }
+    void flush(void);
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+  public:
+    uint32_t getCycleCount(void);
+    uint32_t getCpuFreqMHz(void) { return 240; }
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef _HOST_SIM_FS_H_
+#define _HOST_SIM_FS_H_
+
+/*
+ * fs::FS stand-in backed by a directory on the host, see SimFS.
+ */
+
+#include "Arduino.h"
+
+#define FILE_READ       "r"
+#define FILE_WRITE      "w"
+#define FILE_APPEND     "a"
+
+namespace fs {
+
+class File : public Stream {
+  public:
+    File(FILE* f = NULL) : f(f) {}
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) { return f ? fwrite(buf, 1, size, f) : 0; }
+    using Print::write;
+    int available(void);
+    int read(void) { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+    size_t read(uint8_t* buf, size_t size) { return f ? fread(buf, 1, size, f) : 0; }
+    size_t size(void);
+    void close(void) { if (f) fclose(f); f = NULL; }
+    operator bool() const { return f != NULL; }
+
+  private:
+    FILE* f;
+};
+
+class FS {
+  public:
+    explicit FS(const char* root = ".");
+    void setRoot(const char* root);
+    File open(const char* path, const char* mode = FILE_READ);
+    bool exists(const char* path);
+    bool remove(const char* path);
+
+  private:
+    char root[256];
+    void hostPath(const char* path, char* out, size_t len);
+};
+
+}
+
+using fs::FS;
+using fs::File;
+
+extern fs::FS SimFS;
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef _HOST_SIM_WIRE_H_
+#define _HOST_SIM_WIRE_H_
+
+/*
+ * TwoWire stand-in: transactions are routed to the device models attached to
+ * the matching SimBus port (sim/SimBus.h) instead of a peripheral.
+ */
+
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire : public Stream {
+  public:
+    explicit TwoWire(uint8_t busNum);
+
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    bool end(void);
+    void setClock(uint32_t frequency);
+    uint32_t getClock(void) { return clock; }
+
+    void beginTransmission(uint16_t address);
+    void beginTransmission(uint8_t address) { beginTransmission((uint16_t)address); }
+    void beginTransmission(int address) { beginTransmission((uint16_t)address); }
+    uint8_t endTransmission(bool sendStop);
+    uint8_t endTransmission(void) { return endTransmission(true); }
+
+    uint8_t requestFrom(uint16_t address, uint8_t size, bool sendStop);
+    uint8_t requestFrom(uint16_t address, uint8_t size) { return requestFrom(address, size, true); }
+    uint8_t requestFrom(uint8_t address, uint8_t size, uint8_t sendStop) { return requestFrom((uint16_t)address, size, sendStop != 0); }
+    uint8_t requestFrom(uint8_t address, uint8_t size) { return requestFrom((uint16_t)address, size, true); }
+    uint8_t requestFrom(int address, int size) { return requestFrom((uint16_t)address, (uint8_t)size, true); }
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t len);
+    size_t write(int data) { return write((uint8_t)data); }
+    int available(void);
+    int read(void);
+    int peek(void);
+
+  private:
+    uint8_t num;
+    uint32_t clock;
+    uint16_t txAddress;
+    uint8_t txBuffer[I2C_BUFFER_LENGTH];
+    size_t txLength;
+    bool transmitting;
+    uint8_t rxBuffer[I2C_BUFFER_LENGTH];
+    size_t rxLength;
+    size_t rxIndex;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
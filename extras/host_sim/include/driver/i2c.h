@@ -0,0 +1,10 @@
+#ifndef _HOST_SIM_DRIVER_I2C_H_
+#define _HOST_SIM_DRIVER_I2C_H_
+
+typedef enum {
+  I2C_NUM_0 = 0,
+  I2C_NUM_1,
+  I2C_NUM_MAX
+} i2c_port_t;
+
+#endif
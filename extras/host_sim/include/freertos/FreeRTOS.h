@@ -0,0 +1,27 @@
+#ifndef _HOST_SIM_FREERTOS_H_
+#define _HOST_SIM_FREERTOS_H_
+
+/*
+ * FreeRTOS stand-in for the host simulator: tasks are std::threads, the tick
+ * is 1 ms of wall-clock time. Only the calls used in src/utility exist.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFF)
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define portYIELD_FROM_ISR()    do {} while (0)
+#define tskNO_AFFINITY          0x7FFFFFFF
+#define configMAX_PRIORITIES    25
+
+#endif
@@ -0,0 +1,56 @@
+#include "SimModels.h"
+#include "Arduino.h"
+
+#define OP_POWER_DOWN       0x00
+#define OP_POWER_ON         0x01
+#define OP_RESET            0x07
+
+SimBH1750::SimBH1750(uint8_t address) : SimDevice(address), lux(0), result(0), readyAt(0), measuring(false) {
+}
+
+void SimBH1750::setLux(float lux) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  this->lux = lux;
+}
+
+/*
+ * Measurement opcodes: 0x1x continuous, 0x2x one time; x = 0/1 high
+ * resolution (120 ms), x = 3 low resolution (16 ms).
+ */
+bool SimBH1750::write(const uint8_t* data, size_t len) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  if (len == 0)
+    return true;
+
+  uint8_t op = data[0];
+  switch (op) {
+    case OP_POWER_DOWN:
+    case OP_POWER_ON:
+      return true;
+    case OP_RESET:
+      result = 0;
+      return true;
+    case 0x10: case 0x11: case 0x13:
+    case 0x20: case 0x21: case 0x23:
+      readyAt = micros() + ((op & 0x0F) == 0x03 ? 16000 : 120000);
+      measuring = true;
+      return true;
+    default:
+      return false;
+  }
+}
+
+size_t SimBH1750::read(uint8_t* dest, size_t len) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  if (measuring && (int32_t)(micros() - readyAt) >= 0) {
+    float counts = lux * 1.2f;
+    result = counts > 65535.0f ? 65535 : (uint16_t)counts;
+    measuring = false;
+  }
+  //Before the first measurement completes the chip returns the old result
+  for (size_t i = 0; i < len; i++)
+    dest[i] = i == 0 ? result >> 8 : (i == 1 ? result & 0xFF : 0xFF);
+  return len;
+}
@@ -0,0 +1,107 @@
+#include "SimModels.h"
+#include "Arduino.h"
+#include "SimPins.h"
+
+#define REG_CHIP_ID         0x40
+#define REG_DATA_X_LSB      0x42
+#define REG_DATA_R_LSB      0x48
+#define REG_DATA_R_MSB      0x49
+#define REG_POWER           0x4B
+#define REG_OP_MODE         0x4C
+#define REG_AXES_ENABLE     0x4E
+
+#define OP_MODE_NORMAL      0
+#define OP_MODE_FORCED      1
+#define OP_MODE_SLEEP       3
+
+/* Trim values of a typical part */
+static const uint8_t defaultTrim[][2] = {
+  { 0x5D, 0x00 },                 //dig_x1
+  { 0x5E, 0x00 },                 //dig_y1
+  { 0x62, 0x00 }, { 0x63, 0x00 }, //dig_z4
+  { 0x64, 26 },                   //dig_x2
+  { 0x65, 26 },                   //dig_y2
+  { 0x68, 0x74 }, { 0x69, 0x02 }, //dig_z2 = 628
+  { 0x6A, 0x47 }, { 0x6B, 0x5F }, //dig_z1 = 24391
+  { 0x6C, 0xCA }, { 0x6D, 0x19 }, //dig_xyz1 = 6602
+  { 0x6E, 0x00 }, { 0x6F, 0x00 }, //dig_z3
+  { 0x70, 0xFD },                 //dig_xy2 = -3
+  { 0x71, 29 },                   //dig_xy1
+};
+
+SimBMM150::SimBMM150(uint8_t address)
+  : SimRegisterDevice(address), rawX(0), rawY(0), rawZ(0), rawR(6000), drdyPin(-1) {
+  for (uint8_t i = 0; i < sizeof(defaultTrim) / sizeof(defaultTrim[0]); i++)
+    regs[defaultTrim[i][0]] = defaultTrim[i][1];
+  regs[REG_OP_MODE] = OP_MODE_SLEEP << 1;
+}
+
+void SimBMM150::setRaw(int16_t x, int16_t y, int16_t z, uint16_t rhall) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  rawX = x;
+  rawY = y;
+  rawZ = z;
+  rawR = rhall;
+}
+
+void SimBMM150::convert(void) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  if ((regs[REG_POWER] & 0x01) && ((regs[REG_OP_MODE] >> 1) & 0x03) == OP_MODE_NORMAL)
+    latch();
+}
+
+/*
+ * End of a conversion: pack the values the way the data registers hold
+ * them, set DRDY and raise the DRDY pin if it is enabled.
+ */
+void SimBMM150::latch(void) {
+  regs[0x42] = (rawX & 0x1F) << 3;
+  regs[0x43] = (rawX >> 5) & 0xFF;
+  regs[0x44] = (rawY & 0x1F) << 3;
+  regs[0x45] = (rawY >> 5) & 0xFF;
+  regs[0x46] = (rawZ & 0x7F) << 1;
+  regs[0x47] = (rawZ >> 7) & 0xFF;
+  regs[REG_DATA_R_LSB] = ((rawR & 0x3F) << 2) | 0x01;
+  regs[REG_DATA_R_MSB] = (rawR >> 6) & 0xFF;
+
+  if (drdyPin >= 0 && (regs[REG_AXES_ENABLE] & 0x80))
+    simPinSet(drdyPin, (regs[REG_AXES_ENABLE] & 0x04) ? HIGH : LOW);
+}
+
+uint8_t SimBMM150::readRegister(uint8_t reg) {
+  //Suspend mode: only the power control register is accessible
+  if (!(regs[REG_POWER] & 0x01) && reg != REG_POWER)
+    return 0;
+
+  uint8_t value = regs[reg];
+  if (reg == REG_CHIP_ID)
+    return 0x32;
+  if (reg == REG_DATA_R_MSB) {
+    //Reading the data clears DRDY
+    regs[REG_DATA_R_LSB] &= ~0x01;
+    if (drdyPin >= 0 && (regs[REG_AXES_ENABLE] & 0x80))
+      simPinSet(drdyPin, (regs[REG_AXES_ENABLE] & 0x04) ? LOW : HIGH);
+  }
+  return value;
+}
+
+void SimBMM150::writeRegister(uint8_t reg, uint8_t value) {
+  if (reg == REG_POWER) {
+    bool wake = !(regs[REG_POWER] & 0x01) && (value & 0x01);
+    //Soft reset bits clear themselves
+    regs[REG_POWER] = value & 0x01;
+    if (wake || (value & 0x82))
+      regs[REG_OP_MODE] = OP_MODE_SLEEP << 1;
+    return;
+  }
+  if (!(regs[REG_POWER] & 0x01))
+    return;
+
+  regs[reg] = value;
+  if (reg == REG_OP_MODE && ((value >> 1) & 0x03) == OP_MODE_FORCED) {
+    latch();
+    regs[REG_OP_MODE] = value | (OP_MODE_SLEEP << 1);
+  }
+}
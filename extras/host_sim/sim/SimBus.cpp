@@ -0,0 +1,113 @@
+#include "SimBus.h"
+#include "SimDevice.h"
+
+#include <chrono>
+#include <string.h>
+#include <thread>
+
+SimBus::SimBus() : realtime(false) {
+  memset(devices, 0, sizeof(devices));
+  memset(nackMask, 0, sizeof(nackMask));
+  memset(&stats, 0, sizeof(stats));
+}
+
+SimBus& SimBus::port(uint8_t num) {
+  static SimBus ports[SIM_BUS_PORTS];
+  return ports[num % SIM_BUS_PORTS];
+}
+
+void SimBus::attach(SimDevice* device) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  for (uint8_t i = 0; i < SIM_BUS_MAX_DEVICES; i++) {
+    if (devices[i] == NULL || devices[i]->address() == device->address()) {
+      devices[i] = device;
+      return;
+    }
+  }
+}
+
+void SimBus::detach(SimDevice* device) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  for (uint8_t i = 0; i < SIM_BUS_MAX_DEVICES; i++)
+    if (devices[i] == device)
+      devices[i] = NULL;
+}
+
+void SimBus::setNack(uint8_t address, bool nack) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  nackMask[address & 0x7F] = nack;
+}
+
+sim_bus_stats_t SimBus::getStats(void) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  return stats;
+}
+
+void SimBus::resetStats(void) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  memset(&stats, 0, sizeof(stats));
+}
+
+SimDevice* SimBus::find(uint8_t address) {
+  if (address >= 128 || nackMask[address])
+    return NULL;
+  for (uint8_t i = 0; i < SIM_BUS_MAX_DEVICES; i++)
+    if (devices[i] != NULL && devices[i]->address() == address)
+      return devices[i];
+  return NULL;
+}
+
+/*
+ * Wire time of one transaction: start, address byte and payload at 9 clocks
+ * per byte (8 data + ACK), stop.
+ */
+void SimBus::account(size_t bytes, uint32_t clock) {
+  if (clock == 0)
+    clock = 100000;
+  uint64_t ns = ((uint64_t)(bytes + 1) * 9 + 2) * 1000000000ULL / clock;
+
+  stats.transactions++;
+  stats.busTimeNs += ns;
+  if (realtime)
+    std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+}
+
+uint8_t SimBus::write(uint8_t address, const uint8_t* data, size_t len, bool stop, uint32_t clock) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  SimDevice* device = find(address);
+
+  (void)stop;
+  if (device == NULL) {
+    stats.nacks++;
+    account(0, clock);
+    return 2;
+  }
+  account(len, clock);
+  if (!device->write(data, len)) {
+    stats.nacks++;
+    return 3;
+  }
+  stats.bytesWritten += len;
+  return 0;
+}
+
+size_t SimBus::read(uint8_t address, uint8_t* dest, size_t len, bool stop, uint32_t clock) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  SimDevice* device = find(address);
+  size_t got = device ? device->read(dest, len) : 0;
+
+  (void)stop;
+  if (got == 0) {
+    stats.nacks++;
+    account(0, clock);
+    return 0;
+  }
+  //The master clocks out all len bytes; a device that runs dry leaves SDA high
+  for (size_t i = got; i < len; i++)
+    dest[i] = 0xFF;
+  account(len, clock);
+  stats.bytesRead += len;
+  return len;
+}
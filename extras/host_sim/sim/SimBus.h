@@ -0,0 +1,60 @@
+#ifndef _SIM_BUS_H_
+#define _SIM_BUS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+
+/*
+ * One simulated I2C port. TwoWire hands every finished transaction to the
+ * bus, which routes it to the device model at that address. An address with
+ * no device (or one marked with setNack()) NACKs like the real bus.
+ *
+ * The bus also counts what went over the wire and how long it would have
+ * taken at the programmed SCL clock, so drivers can be compared without
+ * hardware. setRealtime(true) additionally sleeps for that time.
+ */
+
+class SimDevice;
+
+typedef struct {
+  uint32_t transactions;      //Address phases, i.e. writes plus reads
+  uint32_t bytesWritten;      //Payload bytes, not counting the address byte
+  uint32_t bytesRead;
+  uint32_t nacks;
+  uint64_t busTimeNs;         //Wire time at the SCL clock in effect
+} sim_bus_stats_t;
+
+#define SIM_BUS_PORTS       2
+#define SIM_BUS_MAX_DEVICES 16
+
+class SimBus {
+  public:
+    static SimBus& port(uint8_t num);
+
+    void attach(SimDevice* device);
+    void detach(SimDevice* device);
+    void setNack(uint8_t address, bool nack);
+    void setRealtime(bool realtime) { this->realtime = realtime; }
+
+    sim_bus_stats_t getStats(void);
+    void resetStats(void);
+
+    //Called by TwoWire: return 0 on ACK, 2 on address NACK, 3 on data NACK
+    uint8_t write(uint8_t address, const uint8_t* data, size_t len, bool stop, uint32_t clock);
+    //Returns the number of bytes the device supplied, 0 on NACK
+    size_t read(uint8_t address, uint8_t* dest, size_t len, bool stop, uint32_t clock);
+
+  private:
+    SimBus();
+    SimDevice* find(uint8_t address);
+    void account(size_t bytes, uint32_t clock);
+
+    std::recursive_mutex lock;
+    SimDevice* devices[SIM_BUS_MAX_DEVICES];
+    bool nackMask[128];
+    bool realtime;
+    sim_bus_stats_t stats;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "SimDevice.h"
+
+#include <string.h>
+
+SimRegisterDevice::SimRegisterDevice(uint8_t address) : SimDevice(address), pointer(0) {
+  memset(regs, 0, sizeof(regs));
+}
+
+bool SimRegisterDevice::write(const uint8_t* data, size_t len) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  //An empty write is an address probe
+  if (len == 0)
+    return true;
+
+  pointer = data[0];
+  for (size_t i = 1; i < len; i++) {
+    writeRegister(pointer, data[i]);
+    pointer = nextRegister(pointer);
+  }
+  return true;
+}
+
+size_t SimRegisterDevice::read(uint8_t* dest, size_t len) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  for (size_t i = 0; i < len; i++) {
+    dest[i] = readRegister(pointer);
+    pointer = nextRegister(pointer);
+  }
+  return len;
+}
+
+uint8_t SimRegisterDevice::peek(uint8_t reg) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  return regs[reg];
+}
+
+void SimRegisterDevice::poke(uint8_t reg, uint8_t value) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  regs[reg] = value;
+}
@@ -0,0 +1,58 @@
+#ifndef _SIM_DEVICE_H_
+#define _SIM_DEVICE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+
+/*
+ * Base of all device models. Calls arrive with the bus already serialized;
+ * models that are also changed from the test side guard their state with
+ * `lock`.
+ */
+class SimDevice {
+  public:
+    explicit SimDevice(uint8_t address) : addr(address) {}
+    virtual ~SimDevice() {}
+
+    uint8_t address(void) const { return addr; }
+
+    //Master write; return false to NACK a data byte
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+    //Master read; return the number of bytes supplied, 0 to NACK the address
+    virtual size_t read(uint8_t* dest, size_t len) = 0;
+
+  protected:
+    std::recursive_mutex lock;
+
+  private:
+    uint8_t addr;
+};
+
+/*
+ * The common "first byte selects a register, then auto-increment" device.
+ * Models override readRegister()/writeRegister() for side effects (FIFOs,
+ * read-to-clear flags, self-clearing bits) and nextRegister() for registers
+ * that do not advance the pointer.
+ */
+class SimRegisterDevice : public SimDevice {
+  public:
+    explicit SimRegisterDevice(uint8_t address);
+
+    bool write(const uint8_t* data, size_t len);
+    size_t read(uint8_t* dest, size_t len);
+
+    //Direct register access for the test side, no side effects
+    uint8_t peek(uint8_t reg);
+    void poke(uint8_t reg, uint8_t value);
+
+  protected:
+    virtual uint8_t readRegister(uint8_t reg) { return regs[reg]; }
+    virtual void writeRegister(uint8_t reg, uint8_t value) { regs[reg] = value; }
+    virtual uint8_t nextRegister(uint8_t reg) { return reg + 1; }
+
+    uint8_t regs[256];
+    uint8_t pointer;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "SimModels.h"
+
+#define REG_TD_STATUS       0x02
+#define REG_TOUCH1          0x03
+#define REG_TOUCH2          0x09
+#define EVENT_CONTACT       0x80
+
+SimFT6336U::SimFT6336U(uint8_t address) : SimRegisterDevice(address) {
+  regs[0xA3] = 0x64;      //Chip ID
+  regs[0xA6] = 0x10;      //Firmware ID
+  regs[0xA8] = 0x11;      //FocalTech ID
+  regs[0x80] = 0x16;      //Touch threshold
+}
+
+void SimFT6336U::setTouches(uint8_t count, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  uint16_t xy[2][2] = { { x1, y1 }, { x2, y2 } };
+  uint8_t base[2] = { REG_TOUCH1, REG_TOUCH2 };
+
+  regs[REG_TD_STATUS] = count > 2 ? 2 : count;
+  for (uint8_t i = 0; i < 2; i++) {
+    bool down = i < count;
+    regs[base[i]] = (down ? EVENT_CONTACT : 0x40) | ((xy[i][0] >> 8) & 0x0F);
+    regs[base[i] + 1] = xy[i][0] & 0xFF;
+    regs[base[i] + 2] = (i << 4) | ((xy[i][1] >> 8) & 0x0F);
+    regs[base[i] + 3] = xy[i][1] & 0xFF;
+    regs[base[i] + 4] = down ? 0x20 : 0;    //Weight
+    regs[base[i] + 5] = down ? 0x10 : 0;    //Area
+  }
+}
@@ -0,0 +1,34 @@
+#include "SimModels.h"
+
+#define REG_CHARGE_STATUS   0x70
+#define REG_FULL_STATUS     0x71
+#define REG_LEVEL           0x78
+
+SimIP5306::SimIP5306(uint8_t address) : SimRegisterDevice(address) {
+}
+
+void SimIP5306::setLevel(uint8_t percent) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  //Upper nibble is a thermometer code of the LEDs that are off
+  if (percent >= 100)
+    regs[REG_LEVEL] = 0x00;
+  else if (percent >= 75)
+    regs[REG_LEVEL] = 0x80;
+  else if (percent >= 50)
+    regs[REG_LEVEL] = 0xC0;
+  else if (percent >= 25)
+    regs[REG_LEVEL] = 0xE0;
+  else
+    regs[REG_LEVEL] = 0xF0;
+}
+
+void SimIP5306::setCharging(bool charging) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  regs[REG_CHARGE_STATUS] = charging ? (regs[REG_CHARGE_STATUS] | 0x08) : (regs[REG_CHARGE_STATUS] & ~0x08);
+}
+
+void SimIP5306::setFull(bool full) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  regs[REG_FULL_STATUS] = full ? (regs[REG_FULL_STATUS] | 0x08) : (regs[REG_FULL_STATUS] & ~0x08);
+}
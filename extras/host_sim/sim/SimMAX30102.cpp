@@ -0,0 +1,186 @@
+#include "SimModels.h"
+#include "Arduino.h"
+#include "SimPins.h"
+
+#define REG_INTSTAT1        0x00
+#define REG_INTSTAT2        0x01
+#define REG_INTENABLE1      0x02
+#define REG_INTENABLE2      0x03
+#define REG_FIFO_WR_PTR     0x04
+#define REG_FIFO_OVF        0x05
+#define REG_FIFO_RD_PTR     0x06
+#define REG_FIFO_DATA       0x07
+#define REG_FIFO_CONFIG     0x08
+#define REG_MODE_CONFIG     0x09
+#define REG_SLOT1           0x11
+#define REG_SLOT2           0x12
+#define REG_TEMP_INT        0x1F
+#define REG_TEMP_FRAC       0x20
+#define REG_TEMP_CONFIG     0x21
+#define REG_REVISION_ID     0xFE
+#define REG_PART_ID         0xFF
+
+#define INT_A_FULL          0x80
+#define INT_PPG_RDY         0x40
+#define INT_PWR_RDY         0x01
+#define INT_DIE_TEMP_RDY    0x02
+
+SimMAX30102::SimMAX30102(uint8_t address) : SimRegisterDevice(address), intPin(-1), temperature(25.0f) {
+  powerOnReset();
+}
+
+void SimMAX30102::powerOnReset(void) {
+  memset(regs, 0, sizeof(regs));
+  memset(fifo, 0, sizeof(fifo));
+  level = 0;
+  byteIndex = 0;
+  regs[REG_INTSTAT1] = INT_PWR_RDY;
+  regs[REG_REVISION_ID] = 0x03;
+  regs[REG_PART_ID] = 0x15;
+}
+
+/*
+ * Values per sample: 1 in heart rate mode, 2 in SpO2 mode, one per active
+ * slot in multi-LED mode.
+ */
+uint8_t SimMAX30102::channels(void) {
+  uint8_t n = 0;
+
+  switch (regs[REG_MODE_CONFIG] & 0x07) {
+    case 3:
+      return 2;
+    case 7:
+      n += (regs[REG_SLOT1] & 0x07) != 0;
+      n += (regs[REG_SLOT1] & 0x70) != 0;
+      n += (regs[REG_SLOT2] & 0x07) != 0;
+      return n ? n : 1;
+    default:
+      return 1;
+  }
+}
+
+/* INT is open drain, active low */
+void SimMAX30102::updateInt(void) {
+  if (intPin < 0)
+    return;
+  bool active = (regs[REG_INTSTAT1] & regs[REG_INTENABLE1]) || (regs[REG_INTSTAT2] & regs[REG_INTENABLE2]);
+  simPinSet(intPin, active ? LOW : HIGH);
+}
+
+void SimMAX30102::pushSample(uint32_t red, uint32_t ir, uint32_t green) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  uint8_t wr = regs[REG_FIFO_WR_PTR] & 0x1F;
+
+  if (level == 32) {
+    if (regs[REG_FIFO_OVF] < 0x1F)
+      regs[REG_FIFO_OVF]++;
+    if (!(regs[REG_FIFO_CONFIG] & 0x10))
+      return;
+    //Rollover: the oldest sample is overwritten
+    regs[REG_FIFO_RD_PTR] = (regs[REG_FIFO_RD_PTR] + 1) & 0x1F;
+    byteIndex = 0;
+    level--;
+  }
+
+  fifo[wr][0] = red & 0x3FFFF;
+  fifo[wr][1] = ir & 0x3FFFF;
+  fifo[wr][2] = green & 0x3FFFF;
+  regs[REG_FIFO_WR_PTR] = (wr + 1) & 0x1F;
+  level++;
+
+  regs[REG_INTSTAT1] |= INT_PPG_RDY;
+  if (level >= 32 - (regs[REG_FIFO_CONFIG] & 0x0F))
+    regs[REG_INTSTAT1] |= INT_A_FULL;
+  updateInt();
+}
+
+uint8_t SimMAX30102::fifoLevel(void) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  return level;
+}
+
+void SimMAX30102::setTemperature(float celsius) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  temperature = celsius;
+}
+
+uint8_t SimMAX30102::readRegister(uint8_t reg) {
+  uint8_t value;
+
+  switch (reg) {
+    case REG_INTSTAT1:
+    case REG_INTSTAT2:
+      value = regs[reg];
+      regs[reg] = 0;
+      updateInt();
+      return value;
+
+    case REG_FIFO_DATA: {
+      if (level == 0)
+        return 0;
+      uint8_t rd = regs[REG_FIFO_RD_PTR] & 0x1F;
+      uint32_t sample = fifo[rd][byteIndex / 3];
+      value = (sample >> (8 * (2 - byteIndex % 3))) & 0xFF;
+      if (++byteIndex == 3 * channels()) {
+        byteIndex = 0;
+        regs[REG_FIFO_RD_PTR] = (rd + 1) & 0x1F;
+        regs[REG_FIFO_OVF] = 0;
+        level--;
+        regs[REG_INTSTAT1] &= ~INT_A_FULL;
+        updateInt();
+      }
+      return value;
+    }
+
+    default:
+      return regs[reg];
+  }
+}
+
+void SimMAX30102::writeRegister(uint8_t reg, uint8_t value) {
+  switch (reg) {
+    case REG_FIFO_WR_PTR:
+    case REG_FIFO_OVF:
+    case REG_FIFO_RD_PTR:
+      regs[reg] = value & 0x1F;
+      level = (regs[REG_FIFO_WR_PTR] - regs[REG_FIFO_RD_PTR]) & 0x1F;
+      byteIndex = 0;
+      return;
+
+    case REG_MODE_CONFIG:
+      if (value & 0x40) {
+        //RESET clears itself once the registers are back to power-on values
+        powerOnReset();
+        updateInt();
+        return;
+      }
+      regs[reg] = value;
+      byteIndex = 0;
+      return;
+
+    case REG_TEMP_CONFIG:
+      if (value & 0x01) {
+        int16_t sixteenths = (int16_t)lroundf(temperature * 16.0f);
+        regs[REG_TEMP_INT] = (uint8_t)(int8_t)(sixteenths >> 4);
+        regs[REG_TEMP_FRAC] = sixteenths & 0x0F;
+        regs[REG_INTSTAT2] |= INT_DIE_TEMP_RDY;
+        updateInt();
+      }
+      return;
+
+    case REG_INTSTAT1:
+    case REG_INTSTAT2:
+    case REG_REVISION_ID:
+    case REG_PART_ID:
+      return;
+
+    default:
+      regs[reg] = value;
+      if (reg == REG_INTENABLE1 || reg == REG_INTENABLE2)
+        updateInt();
+  }
+}
+
+uint8_t SimMAX30102::nextRegister(uint8_t reg) {
+  return reg == REG_FIFO_DATA ? reg : reg + 1;
+}
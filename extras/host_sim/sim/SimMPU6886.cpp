@@ -0,0 +1,110 @@
+#include "SimModels.h"
+
+#define REG_CONFIG          0x1A
+#define REG_FIFO_EN         0x23
+#define REG_INT_STATUS      0x3A
+#define REG_ACCEL_XOUT_H    0x3B
+#define REG_USER_CTRL       0x6A
+#define REG_PWR_MGMT_1      0x6B
+#define REG_FIFO_COUNTH     0x72
+#define REG_FIFO_COUNTL     0x73
+#define REG_FIFO_R_W        0x74
+#define REG_WHOAMI          0x75
+
+#define FIFO_SIZE           1024
+#define FIFO_FRAME          14
+
+SimMPU6886::SimMPU6886(uint8_t address) : SimRegisterDevice(address) {
+  regs[REG_WHOAMI] = 0x19;
+  regs[REG_PWR_MGMT_1] = 0x40;
+}
+
+void SimMPU6886::setMotion(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, int16_t temp) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  int16_t values[7] = { ax, ay, az, temp, gx, gy, gz };
+
+  for (uint8_t i = 0; i < 7; i++) {
+    regs[REG_ACCEL_XOUT_H + 2 * i] = (uint16_t)values[i] >> 8;
+    regs[REG_ACCEL_XOUT_H + 2 * i + 1] = values[i] & 0xFF;
+  }
+  regs[REG_INT_STATUS] |= 0x01;
+}
+
+bool SimMPU6886::pushFIFO(void) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  if (!(regs[REG_USER_CTRL] & 0x40) || !(regs[REG_FIFO_EN] & 0x18))
+    return false;
+
+  if (fifo.size() + FIFO_FRAME > FIFO_SIZE) {
+    regs[REG_INT_STATUS] |= 0x10;
+    if (regs[REG_CONFIG] & 0x40)
+      return false;
+    //Overwrite mode drops the oldest bytes, so the stream may lose frame alignment
+    fifo.erase(fifo.begin(), fifo.begin() + FIFO_FRAME);
+  }
+  for (uint8_t i = 0; i < FIFO_FRAME; i++)
+    fifo.push_back(regs[REG_ACCEL_XOUT_H + i]);
+  return true;
+}
+
+uint16_t SimMPU6886::fifoLevel(void) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  return fifo.size();
+}
+
+uint8_t SimMPU6886::readRegister(uint8_t reg) {
+  uint8_t value;
+
+  switch (reg) {
+    case REG_INT_STATUS:
+      value = regs[reg];
+      regs[reg] = 0;
+      return value;
+    case REG_FIFO_COUNTH:
+      return fifo.size() >> 8;
+    case REG_FIFO_COUNTL:
+      return fifo.size() & 0xFF;
+    case REG_FIFO_R_W:
+      if (fifo.empty())
+        return 0xFF;
+      value = fifo.front();
+      fifo.pop_front();
+      return value;
+    default:
+      return regs[reg];
+  }
+}
+
+void SimMPU6886::writeRegister(uint8_t reg, uint8_t value) {
+  switch (reg) {
+    case REG_PWR_MGMT_1:
+      if (value & 0x80) {
+        //Device reset: registers back to power-on values, sleep bit set. The
+        //data registers keep the current motion, as if sampling went on.
+        uint8_t data[FIFO_FRAME];
+        memcpy(data, &regs[REG_ACCEL_XOUT_H], FIFO_FRAME);
+        memset(regs, 0, sizeof(regs));
+        memcpy(&regs[REG_ACCEL_XOUT_H], data, FIFO_FRAME);
+        regs[REG_WHOAMI] = 0x19;
+        regs[REG_PWR_MGMT_1] = 0x40;
+        fifo.clear();
+        return;
+      }
+      regs[reg] = value;
+      return;
+    case REG_USER_CTRL:
+      if (value & 0x04)
+        fifo.clear();
+      regs[reg] = value & ~0x05;
+      return;
+    case REG_FIFO_R_W:
+      return;
+    default:
+      regs[reg] = value;
+  }
+}
+
+uint8_t SimMPU6886::nextRegister(uint8_t reg) {
+  return reg == REG_FIFO_R_W ? reg : reg + 1;
+}
@@ -0,0 +1,170 @@
+#ifndef _SIM_MODELS_H_
+#define _SIM_MODELS_H_
+
+#include <stdint.h>
+#include <deque>
+#include <string.h>
+#include "SimDevice.h"
+
+/*
+ * Register-level models of the devices driven by src/utility. Each one covers
+ * what the drivers touch: identification registers, self-clearing command
+ * bits, read-to-clear flags, FIFOs and conversion timing. Measured values are
+ * set from the test side.
+ */
+
+/* MPU6886 accel/gyro, 0x68 */
+class SimMPU6886 : public SimRegisterDevice {
+  public:
+    SimMPU6886(uint8_t address = 0x68);
+
+    //Raw register values, as the driver reads them back
+    void setMotion(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, int16_t temp = 0);
+    //Append one accel+temp+gyro frame if the FIFO is enabled; sets the overflow flag when full
+    bool pushFIFO(void);
+    uint16_t fifoLevel(void);
+
+  protected:
+    uint8_t readRegister(uint8_t reg);
+    void writeRegister(uint8_t reg, uint8_t value);
+    uint8_t nextRegister(uint8_t reg);
+
+  private:
+    std::deque<uint8_t> fifo;
+};
+
+/* BMM150 magnetometer, 0x13 */
+class SimBMM150 : public SimRegisterDevice {
+  public:
+    SimBMM150(uint8_t address = 0x13);
+
+    //Raw 13/13/15 bit axis values and 14 bit hall resistance
+    void setRaw(int16_t x, int16_t y, int16_t z, uint16_t rhall);
+    //Interrupt pin raised on DRDY, -1 for none
+    void setDrdyPin(int pin) { drdyPin = pin; }
+    //Normal mode: start the next conversion (sets DRDY)
+    void convert(void);
+
+  protected:
+    uint8_t readRegister(uint8_t reg);
+    void writeRegister(uint8_t reg, uint8_t value);
+
+  private:
+    int16_t rawX, rawY, rawZ;
+    uint16_t rawR;
+    int drdyPin;
+    void latch(void);
+};
+
+/* MAX30102 pulse oximeter, 0x57 */
+class SimMAX30102 : public SimRegisterDevice {
+  public:
+    SimMAX30102(uint8_t address = 0x57);
+
+    //Append one sample per active LED; honours FIFO_ROLLOVER_EN and counts overflows
+    void pushSample(uint32_t red, uint32_t ir, uint32_t green = 0);
+    uint8_t fifoLevel(void);
+    //Interrupt pin pulled low while INT_STATUS has an enabled flag, -1 for none
+    void setIntPin(int pin) { intPin = pin; }
+    void setTemperature(float celsius);
+
+  protected:
+    uint8_t readRegister(uint8_t reg);
+    void writeRegister(uint8_t reg, uint8_t value);
+    uint8_t nextRegister(uint8_t reg);
+
+  private:
+    uint32_t fifo[32][3];
+    uint8_t level;              //Samples stored, 32 when full (the pointers alone can not tell)
+    uint8_t byteIndex;          //Position inside the sample at FIFO_RD_PTR
+    int intPin;
+    float temperature;
+    uint8_t channels(void);
+    void updateInt(void);
+    void powerOnReset(void);
+};
+
+/* PAJ7620 gesture sensor, 0x73, two register banks */
+class SimPAJ7620 : public SimRegisterDevice {
+  public:
+    SimPAJ7620(uint8_t address = 0x73);
+
+    //Gesture flags as in PAJ7620_ADDR_GES_PS_DET_FLAG_1:0, cleared on read
+    void setGesture(uint16_t flags);
+    uint8_t bank(void) { return regs[0xEF]; }
+
+  protected:
+    uint8_t readRegister(uint8_t reg);
+    void writeRegister(uint8_t reg, uint8_t value);
+
+  private:
+    uint8_t bank1[256];
+};
+
+/* FT6336U touch controller, 0x38 */
+class SimFT6336U : public SimRegisterDevice {
+  public:
+    SimFT6336U(uint8_t address = 0x38);
+
+    void setTouches(uint8_t count, uint16_t x1 = 0, uint16_t y1 = 0, uint16_t x2 = 0, uint16_t y2 = 0);
+};
+
+/* TCS34725 colour sensor, 0x29, command-byte addressing */
+class SimTCS34725 : public SimRegisterDevice {
+  public:
+    SimTCS34725(uint8_t address = 0x29);
+
+    void setRGBC(uint16_t r, uint16_t g, uint16_t b, uint16_t c);
+
+    bool write(const uint8_t* data, size_t len);
+};
+
+/* BH1750FVI ambient light sensor, 0x23, opcode based */
+class SimBH1750 : public SimDevice {
+  public:
+    SimBH1750(uint8_t address = 0x23);
+
+    void setLux(float lux);
+
+    bool write(const uint8_t* data, size_t len);
+    size_t read(uint8_t* dest, size_t len);
+
+  private:
+    float lux;
+    uint16_t result;
+    uint32_t readyAt;           //micros() when the running one-time measurement ends
+    bool measuring;
+};
+
+/* SGP30 gas sensor, 0x58, 16 bit commands with CRC protected replies */
+class SimSGP30 : public SimDevice {
+  public:
+    SimSGP30(uint8_t address = 0x58);
+
+    void setAirQuality(uint16_t co2eq, uint16_t tvoc);
+
+    bool write(const uint8_t* data, size_t len);
+    size_t read(uint8_t* dest, size_t len);
+
+    static uint8_t crc8(const uint8_t* data);
+
+  private:
+    uint16_t co2, tvoc;
+    bool initialized;
+    uint8_t reply[6];
+    size_t replyLen;
+    uint32_t readyAt;
+};
+
+/* IP5306 power management, 0x75 */
+class SimIP5306 : public SimRegisterDevice {
+  public:
+    SimIP5306(uint8_t address = 0x75);
+
+    //Battery level in the 25 % steps the chip reports
+    void setLevel(uint8_t percent);
+    void setCharging(bool charging);
+    void setFull(bool full);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "SimModels.h"
+
+#define REG_BANK_SEL        0xEF
+#define REG_GES_FLAG_0      0x43
+#define REG_GES_FLAG_1      0x44
+
+SimPAJ7620::SimPAJ7620(uint8_t address) : SimRegisterDevice(address) {
+  memset(bank1, 0, sizeof(bank1));
+  regs[0x00] = 0x20;
+  regs[0x01] = 0x76;
+}
+
+void SimPAJ7620::setGesture(uint16_t flags) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  regs[REG_GES_FLAG_0] |= flags & 0xFF;
+  regs[REG_GES_FLAG_1] |= flags >> 8;
+}
+
+uint8_t SimPAJ7620::readRegister(uint8_t reg) {
+  if (reg == REG_BANK_SEL)
+    return regs[reg];
+  if (regs[REG_BANK_SEL] == 1)
+    return bank1[reg];
+
+  uint8_t value = regs[reg];
+  if (reg == REG_GES_FLAG_0 || reg == REG_GES_FLAG_1)
+    regs[reg] = 0;
+  return value;
+}
+
+void SimPAJ7620::writeRegister(uint8_t reg, uint8_t value) {
+  if (reg == REG_BANK_SEL)
+    regs[reg] = value & 0x01;
+  else if (regs[REG_BANK_SEL] == 1)
+    bank1[reg] = value;
+  else if (reg > 0x01 && reg != REG_GES_FLAG_0 && reg != REG_GES_FLAG_1)
+    regs[reg] = value;
+}
@@ -0,0 +1,16 @@
+#ifndef _SIM_PINS_H_
+#define _SIM_PINS_H_
+
+#include <stdint.h>
+
+#define SIM_PIN_COUNT       40
+
+/*
+ * Drive a GPIO from outside the sketch, e.g. a sensor's interrupt line.
+ * Handlers registered with attachInterrupt()/attachInterruptArg() run on the
+ * calling thread when the edge matches, one at a time as on a single core.
+ */
+void simPinSet(uint8_t pin, uint8_t level);
+uint8_t simPinGet(uint8_t pin);
+
+#endif
@@ -0,0 +1,82 @@
+#include "SimModels.h"
+#include "Arduino.h"
+
+#define CMD_INIT_AIR_QUALITY    0x2003
+#define CMD_MEASURE_AIR_QUALITY 0x2008
+#define CMD_SOFT_RESET          0x06
+#define MEASURE_TIME_US         12000
+#define INIT_TIME_US            10000
+
+SimSGP30::SimSGP30(uint8_t address)
+  : SimDevice(address), co2(400), tvoc(0), initialized(false), replyLen(0), readyAt(0) {
+}
+
+void SimSGP30::setAirQuality(uint16_t co2eq, uint16_t tvoc) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  co2 = co2eq;
+  this->tvoc = tvoc;
+}
+
+/* Sensirion CRC-8: polynomial 0x31, init 0xFF, over one 16 bit word */
+uint8_t SimSGP30::crc8(const uint8_t* data) {
+  uint8_t crc = 0xFF;
+
+  for (uint8_t i = 0; i < 2; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+
+bool SimSGP30::write(const uint8_t* data, size_t len) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  if (len == 0)
+    return true;
+  if (len == 1)
+    //General call style soft reset
+    if (data[0] == CMD_SOFT_RESET) {
+      initialized = false;
+      replyLen = 0;
+      return true;
+    }
+  if (len < 2)
+    return false;
+
+  uint16_t cmd = (data[0] << 8) | data[1];
+  replyLen = 0;
+  switch (cmd) {
+    case CMD_INIT_AIR_QUALITY:
+      initialized = true;
+      readyAt = micros() + INIT_TIME_US;
+      return true;
+    case CMD_MEASURE_AIR_QUALITY: {
+      //Without init the sensor reports its baseline values
+      uint16_t words[2] = { initialized ? co2 : (uint16_t)400, initialized ? tvoc : (uint16_t)0 };
+      for (uint8_t i = 0; i < 2; i++) {
+        reply[3 * i] = words[i] >> 8;
+        reply[3 * i + 1] = words[i] & 0xFF;
+        reply[3 * i + 2] = crc8(&reply[3 * i]);
+      }
+      replyLen = 6;
+      readyAt = micros() + MEASURE_TIME_US;
+      return true;
+    }
+    default:
+      return true;
+  }
+}
+
+/* The sensor NACKs its address until the measurement is done */
+size_t SimSGP30::read(uint8_t* dest, size_t len) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  if ((int32_t)(micros() - readyAt) < 0 || replyLen == 0)
+    return 0;
+
+  size_t n = len < replyLen ? len : replyLen;
+  memcpy(dest, reply, n);
+  replyLen = 0;
+  return n;
+}
@@ -0,0 +1,49 @@
+#include "SimModels.h"
+
+#define COMMAND_BIT         0x80
+#define REG_ENABLE          0x00
+#define REG_ID              0x12
+#define REG_STATUS          0x13
+#define REG_CDATAL          0x14
+
+SimTCS34725::SimTCS34725(uint8_t address) : SimRegisterDevice(address) {
+  regs[0x01] = 0xFF;      //ATIME
+  regs[0x03] = 0xFF;      //WTIME
+  regs[REG_ID] = 0x44;
+}
+
+void SimTCS34725::setRGBC(uint16_t r, uint16_t g, uint16_t b, uint16_t c) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  uint16_t values[4] = { c, r, g, b };
+
+  for (uint8_t i = 0; i < 4; i++) {
+    regs[REG_CDATAL + 2 * i] = values[i] & 0xFF;
+    regs[REG_CDATAL + 2 * i + 1] = values[i] >> 8;
+  }
+  //A result is only valid while the ADC runs
+  if ((regs[REG_ENABLE] & 0x03) == 0x03)
+    regs[REG_STATUS] |= 0x01;
+}
+
+/*
+ * Every transaction starts with a command byte; its low 5 bits address the
+ * register, the auto-increment type is assumed.
+ */
+bool SimTCS34725::write(const uint8_t* data, size_t len) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+
+  if (len == 0)
+    return true;
+  if (!(data[0] & COMMAND_BIT))
+    return false;
+
+  pointer = data[0] & 0x1F;
+  for (size_t i = 1; i < len; i++) {
+    if (pointer != REG_ID && pointer != REG_STATUS && pointer < REG_CDATAL)
+      regs[pointer] = data[i];
+    pointer = (pointer + 1) & 0x1F;
+  }
+  if ((regs[REG_ENABLE] & 0x03) != 0x03)
+    regs[REG_STATUS] &= ~0x01;
+  return true;
+}
@@ -0,0 +1,204 @@
+/*
+ * Arduino core stand-in: time, Print/Serial, GPIO with interrupts.
+ */
+
+#include "Arduino.h"
+#include "SimPins.h"
+
+#include <chrono>
+#include <mutex>
+#include <stdarg.h>
+#include <thread>
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+static uint64_t elapsedNs(void) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long millis(void) {
+  return (uint32_t)(elapsedNs() / 1000000);
+}
+
+unsigned long micros(void) {
+  return (uint32_t)(elapsedNs() / 1000);
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  //Sleeping overshoots by tens of microseconds, spin for short delays
+  if (us >= 2000) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+    return;
+  }
+  uint64_t end = elapsedNs() + (uint64_t)us * 1000;
+  while (elapsedNs() < end)
+    ;
+}
+
+void yield(void) {
+  std::this_thread::yield();
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+
+  while (size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base) {
+  if (base == DEC) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", n);
+    return write(buf);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[8 * sizeof(long) + 1];
+  char* p = &buf[sizeof(buf) - 1];
+
+  if (base < 2)
+    base = 10;
+  *p = '\0';
+  do {
+    unsigned long digit = n % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    n /= base;
+  } while (n);
+  return write(p);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[64];
+
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buf[256];
+  va_list args;
+
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0)
+    return 0;
+  if ((size_t)len >= sizeof(buf))
+    len = sizeof(buf) - 1;
+  return write((const uint8_t*)buf, len);
+}
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush(void) {
+  fflush(stdout);
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount(void) {
+  return (uint32_t)(elapsedNs() * getCpuFreqMHz() / 1000);
+}
+
+struct SimPin {
+  uint8_t level;
+  uint8_t mode;
+  int edge;
+  void (*handler)(void);
+  void (*handlerArg)(void*);
+  void* arg;
+};
+
+static SimPin pins[SIM_PIN_COUNT];
+//Handlers run one at a time, like ISRs on a single core
+static std::recursive_mutex isrLock;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= SIM_PIN_COUNT)
+    return;
+  std::lock_guard<std::recursive_mutex> guard(isrLock);
+  pins[pin].mode = mode;
+  if (mode == INPUT_PULLUP)
+    pins[pin].level = HIGH;
+  else if (mode == INPUT_PULLDOWN)
+    pins[pin].level = LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  simPinSet(pin, val);
+}
+
+int digitalRead(uint8_t pin) {
+  return simPinGet(pin);
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+  if (pin >= SIM_PIN_COUNT)
+    return;
+  std::lock_guard<std::recursive_mutex> guard(isrLock);
+  pins[pin].handler = handler;
+  pins[pin].handlerArg = NULL;
+  pins[pin].edge = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+  if (pin >= SIM_PIN_COUNT)
+    return;
+  std::lock_guard<std::recursive_mutex> guard(isrLock);
+  pins[pin].handler = NULL;
+  pins[pin].handlerArg = handler;
+  pins[pin].arg = arg;
+  pins[pin].edge = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin >= SIM_PIN_COUNT)
+    return;
+  std::lock_guard<std::recursive_mutex> guard(isrLock);
+  pins[pin].handler = NULL;
+  pins[pin].handlerArg = NULL;
+  pins[pin].edge = 0;
+}
+
+void simPinSet(uint8_t pin, uint8_t level) {
+  if (pin >= SIM_PIN_COUNT)
+    return;
+  std::lock_guard<std::recursive_mutex> guard(isrLock);
+  SimPin& p = pins[pin];
+
+  level = level ? HIGH : LOW;
+  if (level == p.level)
+    return;
+  p.level = level;
+
+  bool fire = p.edge == CHANGE || (p.edge == RISING && level == HIGH) || (p.edge == FALLING && level == LOW);
+  if (!fire)
+    return;
+  if (p.handler)
+    p.handler();
+  else if (p.handlerArg)
+    p.handlerArg(p.arg);
+}
+
+uint8_t simPinGet(uint8_t pin) {
+  if (pin >= SIM_PIN_COUNT)
+    return LOW;
+  std::lock_guard<std::recursive_mutex> guard(isrLock);
+  return pins[pin].level;
+}
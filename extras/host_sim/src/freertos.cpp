@@ -0,0 +1,257 @@
+/*
+ * FreeRTOS stand-in: tasks on std::thread, semaphores and queues on
+ * std::mutex/std::condition_variable. One tick is one millisecond.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <string.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+unsigned long millis(void);
+
+struct SimTask {
+  std::mutex m;
+  std::condition_variable cv;
+  uint32_t notify;
+  TaskFunction_t fn;
+  void* arg;
+  std::string name;
+
+  SimTask() : notify(0), fn(NULL), arg(NULL) {}
+};
+
+struct SimTaskExit {};
+
+static thread_local SimTask* currentTask = NULL;
+
+template <typename Lock, typename Pred>
+static bool waitTicks(std::condition_variable& cv, Lock& lock, TickType_t ticks, Pred pred) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+static void taskEntry(SimTask* task) {
+  currentTask = task;
+  try {
+    task->fn(task->arg);
+  } catch (SimTaskExit&) {
+  }
+  //The handle is never freed: other threads may still hold and notify it
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+  (void)stack;
+  (void)priority;
+  (void)core;
+
+  SimTask* task = new SimTask();
+  task->fn = fn;
+  task->arg = arg;
+  task->name = name ? name : "";
+  if (handle)
+    *handle = task;
+  std::thread(taskEntry, task).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  //Only self-deletion is supported, which is all the drivers do
+  if (task == NULL || task == currentTask)
+    throw SimTaskExit();
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)millis();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  //Threads not created through xTaskCreate (main) get a handle on first use
+  if (currentTask == NULL)
+    currentTask = new SimTask();
+  return currentTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  SimTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->m);
+
+  waitTicks(task->cv, lock, ticks, [task] { return task->notify != 0; });
+  uint32_t value = task->notify;
+  if (value)
+    task->notify = clearOnExit ? 0 : value - 1;
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  if (task == NULL)
+    return pdFAIL;
+  std::lock_guard<std::mutex> lock(task->m);
+  task->notify++;
+  task->cv.notify_all();
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+  xTaskNotifyGive(task);
+  if (woken)
+    *woken = pdFALSE;
+}
+
+struct SimSemaphore {
+  std::mutex m;
+  std::condition_variable cv;
+  int count;
+  int maxCount;
+  bool recursive;
+  std::thread::id owner;
+  int depth;
+
+  SimSemaphore(int initial, int maxCount, bool recursive)
+    : count(initial), maxCount(maxCount), recursive(recursive), depth(0) {}
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+  return new SimSemaphore(0, 1, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  return new SimSemaphore(1, 1, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+  return new SimSemaphore(1, 1, true);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(sem->m);
+
+  if (!waitTicks(sem->cv, lock, ticks, [sem] { return sem->count > 0; }))
+    return pdFALSE;
+  sem->count--;
+  sem->owner = std::this_thread::get_id();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  std::lock_guard<std::mutex> lock(sem->m);
+
+  if (sem->count >= sem->maxCount)
+    return pdFALSE;
+  sem->count++;
+  sem->owner = std::thread::id();
+  sem->cv.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(sem->m);
+
+  if (sem->depth > 0 && sem->owner == std::this_thread::get_id()) {
+    sem->depth++;
+    return pdTRUE;
+  }
+  if (!waitTicks(sem->cv, lock, ticks, [sem] { return sem->count > 0; }))
+    return pdFALSE;
+  sem->count--;
+  sem->owner = std::this_thread::get_id();
+  sem->depth = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+  std::lock_guard<std::mutex> lock(sem->m);
+
+  if (sem->depth == 0 || sem->owner != std::this_thread::get_id())
+    return pdFALSE;
+  if (--sem->depth == 0) {
+    sem->count++;
+    sem->owner = std::thread::id();
+    sem->cv.notify_one();
+  }
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken) {
+  if (woken)
+    *woken = pdFALSE;
+  return xSemaphoreGive(sem);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+  delete sem;
+}
+
+struct SimQueue {
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<std::vector<uint8_t> > items;
+  size_t length;
+  size_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  SimQueue* queue = new SimQueue();
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->m);
+
+  if (!waitTicks(queue->cv, lock, ticks, [queue] { return queue->items.size() < queue->length; }))
+    return pdFALSE;
+  const uint8_t* p = (const uint8_t*)item;
+  queue->items.push_back(std::vector<uint8_t>(p, p + queue->itemSize));
+  queue->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+  if (woken)
+    *woken = pdFALSE;
+  return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(queue->m);
+
+  if (!waitTicks(queue->cv, lock, ticks, [queue] { return !queue->items.empty(); }))
+    return pdFALSE;
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  queue->cv.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->m);
+  return (UBaseType_t)queue->items.size();
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
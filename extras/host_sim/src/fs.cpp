@@ -0,0 +1,70 @@
+/*
+ * fs::FS backed by a host directory.
+ */
+
+#include "FS.h"
+
+namespace fs {
+
+int File::available(void) {
+  if (!f)
+    return 0;
+  long pos = ftell(f);
+  fseek(f, 0, SEEK_END);
+  long end = ftell(f);
+  fseek(f, pos, SEEK_SET);
+  return (int)(end - pos);
+}
+
+size_t File::size(void) {
+  if (!f)
+    return 0;
+  long pos = ftell(f);
+  fseek(f, 0, SEEK_END);
+  long end = ftell(f);
+  fseek(f, pos, SEEK_SET);
+  return (size_t)end;
+}
+
+FS::FS(const char* root) {
+  setRoot(root);
+}
+
+void FS::setRoot(const char* root) {
+  snprintf(this->root, sizeof(this->root), "%s", root);
+}
+
+void FS::hostPath(const char* path, char* out, size_t len) {
+  snprintf(out, len, "%s/%s", root, path[0] == '/' ? path + 1 : path);
+}
+
+File FS::open(const char* path, const char* mode) {
+  char host[512];
+  char hostMode[4];
+
+  hostPath(path, host, sizeof(host));
+  snprintf(hostMode, sizeof(hostMode), "%sb", mode);
+  return File(fopen(host, hostMode));
+}
+
+bool FS::exists(const char* path) {
+  char host[512];
+
+  hostPath(path, host, sizeof(host));
+  FILE* f = fopen(host, "rb");
+  if (!f)
+    return false;
+  fclose(f);
+  return true;
+}
+
+bool FS::remove(const char* path) {
+  char host[512];
+
+  hostPath(path, host, sizeof(host));
+  return ::remove(host) == 0;
+}
+
+}
+
+fs::FS SimFS(".");
@@ -0,0 +1,79 @@
+/*
+ * TwoWire on top of SimBus. Transfers are buffered exactly like the ESP32
+ * core does: nothing reaches the bus before endTransmission()/requestFrom(),
+ * and both are limited to I2C_BUFFER_LENGTH bytes.
+ */
+
+#include "Wire.h"
+#include "SimBus.h"
+
+TwoWire::TwoWire(uint8_t busNum)
+  : num(busNum), clock(100000), txAddress(0), txLength(0), transmitting(false), rxLength(0), rxIndex(0) {
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  (void)sda;
+  (void)scl;
+  if (frequency)
+    clock = frequency;
+  return true;
+}
+
+bool TwoWire::end(void) {
+  return true;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+  clock = frequency;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+  txAddress = address;
+  txLength = 0;
+  transmitting = true;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  if (!transmitting)
+    return 4;
+  transmitting = false;
+  return SimBus::port(num).write(txAddress, txBuffer, txLength, sendStop, clock);
+}
+
+uint8_t TwoWire::requestFrom(uint16_t address, uint8_t size, bool sendStop) {
+  if (size > I2C_BUFFER_LENGTH)
+    size = I2C_BUFFER_LENGTH;
+  rxIndex = 0;
+  rxLength = SimBus::port(num).read(address, rxBuffer, size, sendStop, clock);
+  return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (!transmitting || txLength >= I2C_BUFFER_LENGTH)
+    return 0;
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t len) {
+  size_t n = 0;
+
+  while (n < len && write(data[n]))
+    n++;
+  return n;
+}
+
+int TwoWire::available(void) {
+  return rxLength - rxIndex;
+}
+
+int TwoWire::read(void) {
+  return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+}
+
+int TwoWire::peek(void) {
+  return rxIndex < rxLength ? rxBuffer[rxIndex] : -1;
+}
+
+TwoWire Wire(0);
+TwoWire Wire1(1);
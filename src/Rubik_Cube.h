@@ -22,8 +22,11 @@
 #include <FS.h>
 #include <SD.h>
 #include "utility/bh1750fvi_driver.h"
+#include "utility/AHRS.h"
 #include "utility/bmm150.h"
+#include "utility/bmm150_calib.h"
 #include "utility/heartRate.h"
+#include "utility/I2CBus.h"
 #include "utility/Ip5306.h"
 #include "utility/MAX30102.h"
 #include "utility/MPU6886.h"
@@ -0,0 +1,506 @@
+#include "AHRS.h"
+
+#define AHRS_DEG_TO_RAD   0.017453292519943295f
+#define AHRS_RAD_TO_DEG   57.29577951308232f
+
+#define Q30_ONE           (1L << 30)
+#define Q30_HALF          (1L << 29)
+
+/**
+  * @brief  Q30 multiply
+  */
+static inline int32_t mulq(int32_t a, int32_t b) {
+  return (int32_t)(((int64_t)a * b + (1L << 29)) >> 30);
+}
+
+/**
+  * @brief  Integer square root, rounded down
+  */
+static uint32_t isqrt64(uint64_t n) {
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > n)
+    bit >>= 2;
+  while (bit) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+/**
+  * @brief  Scale an integer vector to unit length in Q30
+  * @retval false if the vector is zero
+  */
+static bool normalizeQ30(int32_t* x, int32_t* y, int32_t* z) {
+  int32_t vx = *x, vy = *y, vz = *z;
+
+  // Keep the squares clear of int64 overflow
+  while (vx >= (1L << 24) || vx <= -(1L << 24) || vy >= (1L << 24) || vy <= -(1L << 24) ||
+         vz >= (1L << 24) || vz <= -(1L << 24)) {
+    vx >>= 1;
+    vy >>= 1;
+    vz >>= 1;
+  }
+
+  uint32_t norm = isqrt64((int64_t)vx * vx + (int64_t)vy * vy + (int64_t)vz * vz);
+  if (norm == 0)
+    return false;
+
+  int64_t inv = (1LL << 60) / norm;
+  *x = (int32_t)((vx * inv) >> 30);
+  *y = (int32_t)((vy * inv) >> 30);
+  *z = (int32_t)((vz * inv) >> 30);
+  return true;
+}
+
+/**
+  * @brief  Convert a unit quaternion to roll/pitch/yaw in degrees
+  * @param  *q：Orientation
+  * @param  *euler：Angles in degrees
+  * @retval none
+  */
+void ahrsQuatToEuler(const ahrs_quat_t* q, ahrs_euler_t* euler) {
+  float sinp = -2.0f * (q->x * q->z - q->w * q->y);
+  if (sinp > 1.0f)
+    sinp = 1.0f;
+  else if (sinp < -1.0f)
+    sinp = -1.0f;
+
+  euler->roll = atan2f(q->w * q->x + q->y * q->z, 0.5f - q->x * q->x - q->y * q->y) * AHRS_RAD_TO_DEG;
+  euler->pitch = asinf(sinp) * AHRS_RAD_TO_DEG;
+  euler->yaw = atan2f(q->x * q->y + q->w * q->z, 0.5f - q->y * q->y - q->z * q->z) * AHRS_RAD_TO_DEG;
+}
+
+MadgwickAHRS::MadgwickAHRS(float sampleHz, float beta) {
+  begin(sampleHz, beta);
+}
+
+/**
+  * @brief  Set the update rate and filter gain, and reset the orientation
+  * @param  sampleHz：Rate at which update() is called
+  * @param  beta：Gradient descent step, higher trusts accel/mag more
+  * @retval none
+  */
+void MadgwickAHRS::begin(float sampleHz, float beta) {
+  this->beta = beta;
+  dt = 1.0f / sampleHz;
+  reset();
+}
+
+void MadgwickAHRS::reset(void) {
+  q0 = 1.0f;
+  q1 = q2 = q3 = 0.0f;
+}
+
+/**
+  * @brief  Filter step with accelerometer and magnetometer correction
+  * @param  gx,gy,gz：Angular rate in dps
+  * @param  ax,ay,az：Acceleration, any unit
+  * @param  mx,my,mz：Magnetic field in the IMU frame, any unit
+  * @retval none
+  */
+void MadgwickAHRS::update(float gx, float gy, float gz, float ax, float ay, float az,
+                          float mx, float my, float mz) {
+  float recipNorm;
+  float s0, s1, s2, s3;
+  float qDot1, qDot2, qDot3, qDot4;
+  float hx, hy;
+  float _2q0mx, _2q0my, _2q0mz, _2q1mx, _2bx, _2bz, _4bx, _4bz, _2q0, _2q1, _2q2, _2q3, _2q0q2, _2q2q3;
+  float q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+
+  if ((mx == 0.0f) && (my == 0.0f) && (mz == 0.0f)) {
+    updateIMU(gx, gy, gz, ax, ay, az);
+    return;
+  }
+
+  gx *= AHRS_DEG_TO_RAD;
+  gy *= AHRS_DEG_TO_RAD;
+  gz *= AHRS_DEG_TO_RAD;
+
+  // Rate of change of quaternion from gyroscope
+  qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+  qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+  qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+  if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+    recipNorm = 1.0f / sqrtf(ax * ax + ay * ay + az * az);
+    ax *= recipNorm;
+    ay *= recipNorm;
+    az *= recipNorm;
+
+    recipNorm = 1.0f / sqrtf(mx * mx + my * my + mz * mz);
+    mx *= recipNorm;
+    my *= recipNorm;
+    mz *= recipNorm;
+
+    _2q0mx = 2.0f * q0 * mx;
+    _2q0my = 2.0f * q0 * my;
+    _2q0mz = 2.0f * q0 * mz;
+    _2q1mx = 2.0f * q1 * mx;
+    _2q0 = 2.0f * q0;
+    _2q1 = 2.0f * q1;
+    _2q2 = 2.0f * q2;
+    _2q3 = 2.0f * q3;
+    _2q0q2 = 2.0f * q0 * q2;
+    _2q2q3 = 2.0f * q2 * q3;
+    q0q0 = q0 * q0;
+    q0q1 = q0 * q1;
+    q0q2 = q0 * q2;
+    q0q3 = q0 * q3;
+    q1q1 = q1 * q1;
+    q1q2 = q1 * q2;
+    q1q3 = q1 * q3;
+    q2q2 = q2 * q2;
+    q2q3 = q2 * q3;
+    q3q3 = q3 * q3;
+
+    // Reference direction of Earth's magnetic field
+    hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+    hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+    _2bx = sqrtf(hx * hx + hy * hy);
+    _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+    _4bx = 2.0f * _2bx;
+    _4bz = 2.0f * _2bz;
+
+    // Gradient decent algorithm corrective step
+    s0 = -_2q2 * (2.0f * q1q3 - _2q0q2 - ax) + _2q1 * (2.0f * q0q1 + _2q2q3 - ay)
+         - _2bz * q2 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+         + (-_2bx * q3 + _2bz * q1) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
+         + _2bx * q2 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+    s1 = _2q3 * (2.0f * q1q3 - _2q0q2 - ax) + _2q0 * (2.0f * q0q1 + _2q2q3 - ay)
+         - 4.0f * q1 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az)
+         + _2bz * q3 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+         + (_2bx * q2 + _2bz * q0) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
+         + (_2bx * q3 - _4bz * q1) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+    s2 = -_2q0 * (2.0f * q1q3 - _2q0q2 - ax) + _2q3 * (2.0f * q0q1 + _2q2q3 - ay)
+         - 4.0f * q2 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az)
+         + (-_4bx * q2 - _2bz * q0) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+         + (_2bx * q1 + _2bz * q3) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
+         + (_2bx * q0 - _4bz * q2) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+    s3 = _2q1 * (2.0f * q1q3 - _2q0q2 - ax) + _2q2 * (2.0f * q0q1 + _2q2q3 - ay)
+         + (-_4bx * q3 + _2bz * q1) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx)
+         + (-_2bx * q0 + _2bz * q2) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my)
+         + _2bx * q1 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+    // Zero gradient when already aligned, nothing to correct
+    float sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if (sNorm > 0.0f) {
+      recipNorm = beta / sqrtf(sNorm);
+      qDot1 -= recipNorm * s0;
+      qDot2 -= recipNorm * s1;
+      qDot3 -= recipNorm * s2;
+      qDot4 -= recipNorm * s3;
+    }
+  }
+
+  q0 += qDot1 * dt;
+  q1 += qDot2 * dt;
+  q2 += qDot3 * dt;
+  q3 += qDot4 * dt;
+
+  recipNorm = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  q0 *= recipNorm;
+  q1 *= recipNorm;
+  q2 *= recipNorm;
+  q3 *= recipNorm;
+}
+
+/**
+  * @brief  Filter step with accelerometer correction only
+  * @param  gx,gy,gz：Angular rate in dps
+  * @param  ax,ay,az：Acceleration, any unit
+  * @retval none
+  */
+void MadgwickAHRS::updateIMU(float gx, float gy, float gz, float ax, float ay, float az) {
+  float recipNorm;
+  float s0, s1, s2, s3;
+  float qDot1, qDot2, qDot3, qDot4;
+  float _2q0, _2q1, _2q2, _2q3, _4q0, _4q1, _4q2, _8q1, _8q2, q0q0, q1q1, q2q2, q3q3;
+
+  gx *= AHRS_DEG_TO_RAD;
+  gy *= AHRS_DEG_TO_RAD;
+  gz *= AHRS_DEG_TO_RAD;
+
+  qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+  qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+  qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+  if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+    recipNorm = 1.0f / sqrtf(ax * ax + ay * ay + az * az);
+    ax *= recipNorm;
+    ay *= recipNorm;
+    az *= recipNorm;
+
+    _2q0 = 2.0f * q0;
+    _2q1 = 2.0f * q1;
+    _2q2 = 2.0f * q2;
+    _2q3 = 2.0f * q3;
+    _4q0 = 4.0f * q0;
+    _4q1 = 4.0f * q1;
+    _4q2 = 4.0f * q2;
+    _8q1 = 8.0f * q1;
+    _8q2 = 8.0f * q2;
+    q0q0 = q0 * q0;
+    q1q1 = q1 * q1;
+    q2q2 = q2 * q2;
+    q3q3 = q3 * q3;
+
+    s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+    s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+    s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+    s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+    // Zero gradient when already aligned, nothing to correct
+    float sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if (sNorm > 0.0f) {
+      recipNorm = beta / sqrtf(sNorm);
+      qDot1 -= recipNorm * s0;
+      qDot2 -= recipNorm * s1;
+      qDot3 -= recipNorm * s2;
+      qDot4 -= recipNorm * s3;
+    }
+  }
+
+  q0 += qDot1 * dt;
+  q1 += qDot2 * dt;
+  q2 += qDot3 * dt;
+  q3 += qDot4 * dt;
+
+  recipNorm = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  q0 *= recipNorm;
+  q1 *= recipNorm;
+  q2 *= recipNorm;
+  q3 *= recipNorm;
+}
+
+/**
+  * @brief  Filter step from driver samples
+  * @param  *imu：Scaled MPU6886 sample
+  * @param  *mag：Compensated BMM150 sample in the IMU frame, NULL if none is new
+  * @retval none
+  */
+void MadgwickAHRS::update(const mpu6886_motion_t* imu, const bmm150_mag_data* mag) {
+  if (mag == NULL) {
+    updateIMU(imu->gx, imu->gy, imu->gz, imu->ax, imu->ay, imu->az);
+    return;
+  }
+  update(imu->gx, imu->gy, imu->gz, imu->ax, imu->ay, imu->az, mag->x, mag->y, mag->z);
+}
+
+void MadgwickAHRS::getQuaternion(ahrs_quat_t* q) {
+  q->w = q0;
+  q->x = q1;
+  q->y = q2;
+  q->z = q3;
+}
+
+void MadgwickAHRS::getEuler(ahrs_euler_t* euler) {
+  ahrs_quat_t q;
+  getQuaternion(&q);
+  ahrsQuatToEuler(&q, euler);
+}
+
+MahonyAHRSFixed::MahonyAHRSFixed(float sampleHz, float kp, float ki) {
+  begin(sampleHz, kp, ki);
+}
+
+/**
+  * @brief  Set the update rate and filter gains, and reset the orientation
+  * @param  sampleHz：Rate at which update() is called
+  * @param  kp：Proportional gain, higher trusts accel/mag more
+  * @param  ki：Integral gain for gyro bias, 0 to disable
+  * @retval none
+  */
+void MahonyAHRSFixed::begin(float sampleHz, float kp, float ki) {
+  float dt = 1.0f / sampleHz;
+
+  gyroGain = (int64_t)(0.5 * dt * (AHRS_DEG_TO_RAD / 1000.0) * (double)(1LL << 46) + 0.5);
+  kpGain = (int32_t)(kp * dt * Q30_ONE + 0.5f);
+  kiGain = (int32_t)(2.0f * ki * dt * Q30_ONE + 0.5f);
+  halfDt = (int32_t)(0.5f * dt * Q30_ONE + 0.5f);
+  reset();
+}
+
+void MahonyAHRSFixed::reset(void) {
+  q0 = Q30_ONE;
+  q1 = q2 = q3 = 0;
+  ix = iy = iz = 0;
+}
+
+/**
+  * @brief  Filter step
+  * @param  gx,gy,gz：Angular rate in milli-dps
+  * @param  ax,ay,az：Acceleration, any unit
+  * @param  mx,my,mz：Magnetic field in the IMU frame, any unit, all zero if none
+  * @retval none
+  */
+void MahonyAHRSFixed::update(int32_t gx, int32_t gy, int32_t gz, int32_t ax, int32_t ay, int32_t az,
+                             int32_t mx, int32_t my, int32_t mz) {
+  int32_t ex = 0, ey = 0, ez = 0;
+
+  if (normalizeQ30(&ax, &ay, &az)) {
+    int32_t q0q0 = mulq(q0, q0);
+    int32_t q0q1 = mulq(q0, q1);
+    int32_t q0q2 = mulq(q0, q2);
+    int32_t q0q3 = mulq(q0, q3);
+    int32_t q1q1 = mulq(q1, q1);
+    int32_t q1q2 = mulq(q1, q2);
+    int32_t q1q3 = mulq(q1, q3);
+    int32_t q2q2 = mulq(q2, q2);
+    int32_t q2q3 = mulq(q2, q3);
+    int32_t q3q3 = mulq(q3, q3);
+
+    // Estimated direction of gravity, halved
+    int32_t vx = q1q3 - q0q2;
+    int32_t vy = q0q1 + q2q3;
+    int32_t vz = q0q0 - Q30_HALF + q3q3;
+
+    ex = mulq(ay, vz) - mulq(az, vy);
+    ey = mulq(az, vx) - mulq(ax, vz);
+    ez = mulq(ax, vy) - mulq(ay, vx);
+
+    if (normalizeQ30(&mx, &my, &mz)) {
+      // Reference direction of Earth's magnetic field
+      int32_t hx = 2 * (mulq(mx, Q30_HALF - q2q2 - q3q3) + mulq(my, q1q2 - q0q3) + mulq(mz, q1q3 + q0q2));
+      int32_t hy = 2 * (mulq(mx, q1q2 + q0q3) + mulq(my, Q30_HALF - q1q1 - q3q3) + mulq(mz, q2q3 - q0q1));
+      int32_t bx = isqrt64((int64_t)hx * hx + (int64_t)hy * hy);
+      int32_t bz = 2 * (mulq(mx, q1q3 - q0q2) + mulq(my, q2q3 + q0q1) + mulq(mz, Q30_HALF - q1q1 - q2q2));
+
+      // Estimated direction of magnetic field, halved
+      int32_t wx = mulq(bx, Q30_HALF - q2q2 - q3q3) + mulq(bz, q1q3 - q0q2);
+      int32_t wy = mulq(bx, q1q2 - q0q3) + mulq(bz, q0q1 + q2q3);
+      int32_t wz = mulq(bx, q0q2 + q1q3) + mulq(bz, Q30_HALF - q1q1 - q2q2);
+
+      ex += mulq(my, wz) - mulq(mz, wy);
+      ey += mulq(mz, wx) - mulq(mx, wz);
+      ez += mulq(mx, wy) - mulq(my, wx);
+    }
+
+    if (kiGain) {
+      ix += mulq(ex, kiGain);
+      iy += mulq(ey, kiGain);
+      iz += mulq(ez, kiGain);
+    }
+  }
+
+  // Half rotation angle over this step: gyro + bias estimate + proportional feedback
+  int32_t hgx = (int32_t)((gx * gyroGain) >> 16) + mulq(ix, halfDt) + mulq(ex, kpGain);
+  int32_t hgy = (int32_t)((gy * gyroGain) >> 16) + mulq(iy, halfDt) + mulq(ey, kpGain);
+  int32_t hgz = (int32_t)((gz * gyroGain) >> 16) + mulq(iz, halfDt) + mulq(ez, kpGain);
+
+  int32_t qa = q0, qb = q1, qc = q2;
+  q0 += -mulq(qb, hgx) - mulq(qc, hgy) - mulq(q3, hgz);
+  q1 += mulq(qa, hgx) + mulq(qc, hgz) - mulq(q3, hgy);
+  q2 += mulq(qa, hgy) - mulq(qb, hgz) + mulq(q3, hgx);
+  q3 += mulq(qa, hgz) + mulq(qb, hgy) - mulq(qc, hgx);
+
+  uint32_t norm = isqrt64((int64_t)q0 * q0 + (int64_t)q1 * q1 + (int64_t)q2 * q2 + (int64_t)q3 * q3);
+  if (norm == 0) {
+    reset();
+    return;
+  }
+  int64_t inv = (1LL << 60) / norm;
+  q0 = (int32_t)((q0 * inv) >> 30);
+  q1 = (int32_t)((q1 * inv) >> 30);
+  q2 = (int32_t)((q2 * inv) >> 30);
+  q3 = (int32_t)((q3 * inv) >> 30);
+}
+
+/**
+  * @brief  Filter step from driver samples
+  * @param  *imu：MPU6886 sample in milli-g / milli-dps
+  * @param  *mag：BMM150 sample in 1/16 uT in the IMU frame, NULL if none is new
+  * @retval none
+  */
+void MahonyAHRSFixed::update(const mpu6886_fixed_t* imu, const bmm150_mag_data_q4* mag) {
+  if (mag == NULL || mag->x == BMM150_OVERFLOW_OUTPUT_Q4 || mag->y == BMM150_OVERFLOW_OUTPUT_Q4 ||
+      mag->z == BMM150_OVERFLOW_OUTPUT_Q4) {
+    update(imu->gx, imu->gy, imu->gz, imu->ax, imu->ay, imu->az, 0, 0, 0);
+    return;
+  }
+  update(imu->gx, imu->gy, imu->gz, imu->ax, imu->ay, imu->az, mag->x, mag->y, mag->z);
+}
+
+void MahonyAHRSFixed::getQuaternionQ30(int32_t q[4]) {
+  q[0] = q0;
+  q[1] = q1;
+  q[2] = q2;
+  q[3] = q3;
+}
+
+void MahonyAHRSFixed::getQuaternion(ahrs_quat_t* q) {
+  const float scale = 1.0f / Q30_ONE;
+  q->w = q0 * scale;
+  q->x = q1 * scale;
+  q->y = q2 * scale;
+  q->z = q3 * scale;
+}
+
+void MahonyAHRSFixed::getEuler(ahrs_euler_t* euler) {
+  ahrs_quat_t q;
+  getQuaternion(&q);
+  ahrsQuatToEuler(&q, euler);
+}
+
+/**
+  * @brief  Time both filters on synthetic data. Inputs are prepared up front so
+  *         only the filter update is counted.
+  * @param  iterations：Number of updates per filter
+  * @param  madgwickCycles：Average CPU cycles per MadgwickAHRS::update
+  * @param  mahonyCycles：Average CPU cycles per MahonyAHRSFixed::update
+  * @retval none
+  */
+void ahrsBenchmark(uint32_t iterations, uint32_t* madgwickCycles, uint32_t* mahonyCycles) {
+  const uint8_t n = 16;
+  mpu6886_motion_t motion[n];
+  bmm150_mag_data mag[n];
+  mpu6886_fixed_t fixed[n];
+  bmm150_mag_data_q4 magq[n];
+
+  for (uint8_t i = 0; i < n; i++) {
+    float a = i * (2.0f * (float)PI / n);
+    motion[i].ax = 0.1f * cosf(a);
+    motion[i].ay = 0.1f * sinf(a);
+    motion[i].az = 1.0f;
+    motion[i].gx = 5.0f * sinf(a);
+    motion[i].gy = 5.0f * cosf(a);
+    motion[i].gz = 30.0f;
+    motion[i].t = 25.0f;
+    mag[i].x = (int16_t)(30 * cosf(a));
+    mag[i].y = (int16_t)(30 * sinf(a));
+    mag[i].z = -40;
+
+    fixed[i].ax = (int16_t)(motion[i].ax * 1000);
+    fixed[i].ay = (int16_t)(motion[i].ay * 1000);
+    fixed[i].az = (int16_t)(motion[i].az * 1000);
+    fixed[i].gx = (int32_t)(motion[i].gx * 1000);
+    fixed[i].gy = (int32_t)(motion[i].gy * 1000);
+    fixed[i].gz = (int32_t)(motion[i].gz * 1000);
+    fixed[i].temp = 2500;
+    magq[i].x = mag[i].x * 16;
+    magq[i].y = mag[i].y * 16;
+    magq[i].z = mag[i].z * 16;
+  }
+
+  if (iterations == 0)
+    iterations = 1;
+
+  MadgwickAHRS madgwick;
+  uint32_t start = ESP.getCycleCount();
+  for (uint32_t i = 0; i < iterations; i++)
+    madgwick.update(&motion[i % n], &mag[i % n]);
+  *madgwickCycles = (ESP.getCycleCount() - start) / iterations;
+
+  MahonyAHRSFixed mahony;
+  start = ESP.getCycleCount();
+  for (uint32_t i = 0; i < iterations; i++)
+    mahony.update(&fixed[i % n], &magq[i % n]);
+  *mahonyCycles = (ESP.getCycleCount() - start) / iterations;
+}
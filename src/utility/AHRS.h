@@ -0,0 +1,106 @@
+#ifndef _AHRS_H_
+#define _AHRS_H_
+
+#include <Arduino.h>
+#include "MPU6886.h"
+#include "bmm150.h"
+
+/*
+ * Orientation filters fusing the MPU6886 (accel/gyro) with the BMM150 (mag).
+ *
+ * Feed one update per IMU sample, e.g. from the MPU6886 data-ready stream, and
+ * pass the latest magnetometer reading whenever a new one is available (the
+ * BMM150 runs far slower than the IMU); pass no magnetometer in between and
+ * the filter falls back to accel/gyro only for that step.
+ *
+ * The magnetometer axes must already be rotated into the IMU frame.
+ */
+
+#define AHRS_DEFAULT_SAMPLE_HZ      500.0f
+#define AHRS_DEFAULT_BETA           0.1f        //Madgwick gradient step
+#define AHRS_DEFAULT_KP             0.5f        //Mahony proportional gain
+#define AHRS_DEFAULT_KI             0.0f        //Mahony integral gain
+
+typedef struct {
+  float w, x, y, z;
+} ahrs_quat_t;
+
+// Degrees, aerospace sequence (yaw, then pitch, then roll)
+typedef struct {
+  float roll, pitch, yaw;
+} ahrs_euler_t;
+
+void ahrsQuatToEuler(const ahrs_quat_t* q, ahrs_euler_t* euler);
+
+/*
+ * Madgwick gradient descent filter in single precision float.
+ */
+class MadgwickAHRS {
+  public:
+    MadgwickAHRS(float sampleHz = AHRS_DEFAULT_SAMPLE_HZ, float beta = AHRS_DEFAULT_BETA);
+
+    void begin(float sampleHz, float beta = AHRS_DEFAULT_BETA);
+    void reset(void);
+
+    /**
+      * @brief  One filter step. Gyro in dps; accel and mag in any unit (only
+      *         the direction is used). A zero mag vector skips the mag correction.
+      */
+    void update(float gx, float gy, float gz, float ax, float ay, float az,
+                float mx, float my, float mz);
+    void updateIMU(float gx, float gy, float gz, float ax, float ay, float az);
+    void update(const mpu6886_motion_t* imu, const bmm150_mag_data* mag = NULL);
+
+    void getQuaternion(ahrs_quat_t* q);
+    void getEuler(ahrs_euler_t* euler);
+
+  private:
+    float q0, q1, q2, q3;
+    float beta;
+    float dt;
+};
+
+/*
+ * Mahony complementary filter in Q30 fixed point, fed straight from the
+ * integer sensor outputs (mpu6886_fixed_t, bmm150_mag_data_q4) so no float
+ * work is done per sample. Quaternion, error terms and the gyro bias
+ * integral (rad/s) are all Q30.
+ */
+class MahonyAHRSFixed {
+  public:
+    MahonyAHRSFixed(float sampleHz = AHRS_DEFAULT_SAMPLE_HZ, float kp = AHRS_DEFAULT_KP,
+                    float ki = AHRS_DEFAULT_KI);
+
+    void begin(float sampleHz, float kp = AHRS_DEFAULT_KP, float ki = AHRS_DEFAULT_KI);
+    void reset(void);
+
+    /**
+      * @brief  One filter step. Gyro in milli-dps; accel and mag in any integer
+      *         unit. A zero mag vector skips the mag correction.
+      */
+    void update(int32_t gx, int32_t gy, int32_t gz, int32_t ax, int32_t ay, int32_t az,
+                int32_t mx, int32_t my, int32_t mz);
+    void update(const mpu6886_fixed_t* imu, const bmm150_mag_data_q4* mag = NULL);
+
+    void getQuaternion(ahrs_quat_t* q);
+    void getQuaternionQ30(int32_t q[4]);
+    void getEuler(ahrs_euler_t* euler);
+
+  private:
+    int32_t q0, q1, q2, q3;
+    int32_t ix, iy, iz;     //Gyro bias integral, rad/s, Q30
+    int64_t gyroGain;       //milli-dps -> Q30 half angle per step, Q16
+    int32_t kpGain;         //Kp * dt, Q30
+    int32_t kiGain;         //2 * Ki * dt, Q30
+    int32_t halfDt;         //dt / 2, Q30
+};
+
+/**
+  * @brief  Time both filters on synthetic data
+  * @param  iterations：Number of updates per filter
+  * @param  madgwickCycles：Average CPU cycles per MadgwickAHRS::update
+  * @param  mahonyCycles：Average CPU cycles per MahonyAHRSFixed::update
+  */
+void ahrsBenchmark(uint32_t iterations, uint32_t* madgwickCycles, uint32_t* mahonyCycles);
+
+#endif
@@ -25,14 +25,9 @@ FT6336U::~FT6336U() {
 void FT6336U::begin(void) {
     // Initialize I2C
 #ifdef ESP32 || ESP8266
-    if(sda != -1 && scl != -1) {
-        Wire.begin(sda, scl); 
-    }
-    else {
-        Wire.begin(); 
-    }
+    i2c.getBus().begin(sda, scl); 
 #else 
-    Wire.begin(); 
+    i2c.getBus().begin(); 
 #endif
 	// Int Pin Configuration
 	pinMode(int_n, INPUT); 
@@ -60,16 +55,10 @@ uint8_t FT6336U::read_touch_number(void) {
 }
 // Touch 1 functions
 uint16_t FT6336U::read_touch1_x(void) {
-    uint8_t read_buf[2];
-    read_buf[0] = readByte(FT6336U_ADDR_TOUCH1_X);
-    read_buf[1] = readByte(FT6336U_ADDR_TOUCH1_X + 1);
-	return ((read_buf[0] & 0x0f) << 8) | read_buf[1];
+    return readCoord(FT6336U_ADDR_TOUCH1_X);
 }
 uint16_t FT6336U::read_touch1_y(void) {
-    uint8_t read_buf[2];
-    read_buf[0] = readByte(FT6336U_ADDR_TOUCH1_Y);
-    read_buf[1] = readByte(FT6336U_ADDR_TOUCH1_Y + 1);
-	return ((read_buf[0] & 0x0f) << 8) | read_buf[1];
+    return readCoord(FT6336U_ADDR_TOUCH1_Y);
 }
 uint8_t FT6336U::read_touch1_event(void) {
     return readByte(FT6336U_ADDR_TOUCH1_EVENT) >> 6;
@@ -85,16 +74,10 @@ uint8_t FT6336U::read_touch1_misc(void) {
 }
 // Touch 2 functions
 uint16_t FT6336U::read_touch2_x(void) {
-    uint8_t read_buf[2];
-    read_buf[0] = readByte(FT6336U_ADDR_TOUCH2_X);
-    read_buf[1] = readByte(FT6336U_ADDR_TOUCH2_X + 1);
-	return ((read_buf[0] & 0x0f) << 8) | read_buf[1];
+    return readCoord(FT6336U_ADDR_TOUCH2_X);
 }
 uint16_t FT6336U::read_touch2_y(void) {
-    uint8_t read_buf[2];
-    read_buf[0] = readByte(FT6336U_ADDR_TOUCH2_Y);
-    read_buf[1] = readByte(FT6336U_ADDR_TOUCH2_Y + 1);
-	return ((read_buf[0] & 0x0f) << 8) | read_buf[1];
+    return readCoord(FT6336U_ADDR_TOUCH2_Y);
 }
 uint8_t FT6336U::read_touch2_event(void) {
     return readByte(FT6336U_ADDR_TOUCH2_EVENT) >> 6;
@@ -212,50 +195,41 @@ uint8_t FT6336U::read_state(void) {
 						//
 						//
 FT6336U_TouchPointType FT6336U::scan(void){
-    touchPoint.touch_count = read_td_status(); 
-
-    if(touchPoint.touch_count == 0) {
-        touchPoint.tp[0].status = release; 
-        touchPoint.tp[1].status = release; 
-    }
-    else if(touchPoint.touch_count == 1) {
-        uint8_t id1 = read_touch1_id(); // id1 = 0 or 1
-        touchPoint.tp[id1].status = (touchPoint.tp[id1].status == release) ? touch : stream; 
-        touchPoint.tp[id1].x = read_touch1_x(); 
-        touchPoint.tp[id1].y = read_touch1_y(); 
-        touchPoint.tp[~id1 & 0x01].status = release; 
-    }
-    else {
-        uint8_t id1 = read_touch1_id(); // id1 = 0 or 1
-        touchPoint.tp[id1].status = (touchPoint.tp[id1].status == release) ? touch : stream; 
-        touchPoint.tp[id1].x = read_touch1_x(); 
-        touchPoint.tp[id1].y = read_touch1_y(); 
-        uint8_t id2 = read_touch2_id(); // id2 = 0 or 1(~id1 & 0x01)
-        touchPoint.tp[id2].status = (touchPoint.tp[id2].status == release) ? touch : stream; 
-        touchPoint.tp[id2].x = read_touch2_x(); 
-        touchPoint.tp[id2].y = read_touch2_y(); 
-    }
+    uint8_t buf[FT6336U_SCAN_LEN]; 
+    I2C_STATS_SITE(i2c.getBus(), "FT6336U::scan"); 
 
+    if(i2c.readRegs(FT6336U_ADDR_TD_STATUS, buf, FT6336U_SCAN_LEN) == FT6336U_SCAN_LEN) 
+        parseScan(buf); 
     return touchPoint; 
+}
 
+bool FT6336U::scan_start(void) {
+    uint8_t reg = FT6336U_ADDR_TD_STATUS; 
+    I2C_STATS_XFER_SITE(&scanXfer, "FT6336U::scan_start"); 
+    return i2c.submit(&scanXfer, &reg, 1, scanBuf, FT6336U_SCAN_LEN); 
 }
 
+FT6336U_TouchPointType FT6336U::scan_result(void) {
+    if(scanXfer.done()) {
+        parseScan(scanBuf); 
+        scanXfer.status = I2C_XFER_IDLE; 
+    }
+    return touchPoint; 
+}
 
 // Private Function
 uint8_t FT6336U::readByte(uint8_t addr) {
-    uint8_t rdData; 
-    uint8_t rdDataCount; 
-    do {
-        Wire.beginTransmission(I2C_ADDR_FT6336U); 
-        Wire.write(addr); 
-        Wire.endTransmission(false); // Restart
-        delay(10); 
-        rdDataCount = Wire.requestFrom(I2C_ADDR_FT6336U, 1); 
-    } while(rdDataCount == 0); 
-    while(Wire.available()) {
-        rdData = Wire.read(); 
+    uint8_t rdData = 0; 
+    for(uint8_t i = 0; i < FT6336U_READ_RETRIES; i++) {
+        if(i2c.readReg(addr, &rdData)) // Restart
+            break; 
     }
     return rdData; 
+}
+uint16_t FT6336U::readCoord(uint8_t addr) {
+    uint8_t read_buf[2] = {0, 0}; 
+    i2c.readRegs(addr, read_buf, 2); 
+	return ((read_buf[0] & 0x0f) << 8) | read_buf[1];
 
 }
 void FT6336U::writeByte(uint8_t addr, uint8_t data) {
@@ -264,8 +238,33 @@ void FT6336U::writeByte(uint8_t addr, uint8_t data) {
     DEBUG_PRINT(addr, HEX)
     DEBUG_PRINT(" -> 0x") DEBUG_PRINTLN(data, HEX)
 	
-	Wire.beginTransmission(I2C_ADDR_FT6336U); 
-    Wire.write(addr); 
-    Wire.write(data); 
-    Wire.endTransmission(); 
-}
\ No newline at end of file
+    i2c.writeReg(addr, data); 
+}
+// buf holds TD_STATUS .. TOUCH2_Y, see FT6336U_SCAN_LEN
+void FT6336U::parseScan(const uint8_t *buf) {
+    const uint8_t *p1 = buf + (FT6336U_ADDR_TOUCH1_X - FT6336U_ADDR_TD_STATUS); 
+    const uint8_t *p2 = buf + (FT6336U_ADDR_TOUCH2_X - FT6336U_ADDR_TD_STATUS); 
+
+    touchPoint.touch_count = buf[0] & 0x0F; 
+
+    if(touchPoint.touch_count == 0) {
+        touchPoint.tp[0].status = release; 
+        touchPoint.tp[1].status = release; 
+        return; 
+    }
+
+    uint8_t id1 = (p1[2] >> 4) & 0x01; // id1 = 0 or 1
+    touchPoint.tp[id1].status = (touchPoint.tp[id1].status == release) ? touch : stream; 
+    touchPoint.tp[id1].x = ((p1[0] & 0x0f) << 8) | p1[1]; 
+    touchPoint.tp[id1].y = ((p1[2] & 0x0f) << 8) | p1[3]; 
+
+    if(touchPoint.touch_count == 1) {
+        touchPoint.tp[~id1 & 0x01].status = release; 
+    }
+    else {
+        uint8_t id2 = (p2[2] >> 4) & 0x01; // id2 = 0 or 1(~id1 & 0x01)
+        touchPoint.tp[id2].status = (touchPoint.tp[id2].status == release) ? touch : stream; 
+        touchPoint.tp[id2].x = ((p2[0] & 0x0f) << 8) | p2[1]; 
+        touchPoint.tp[id2].y = ((p2[2] & 0x0f) << 8) | p2[3]; 
+    }
+}
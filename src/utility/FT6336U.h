@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <Arduino.h>
+#include "I2CBus.h"
 
 #define I2C_ADDR_FT6336U 0x38
 
@@ -42,6 +43,10 @@ typedef enum {
 #define FT6336U_ADDR_TOUCH2_WEIGHT  0x0D
 #define FT6336U_ADDR_TOUCH2_MISC    0x0E
 
+// TD_STATUS through TOUCH2_Y, read in one burst by scan()
+#define FT6336U_SCAN_LEN            (FT6336U_ADDR_TOUCH2_Y + 2 - FT6336U_ADDR_TD_STATUS)
+#define FT6336U_READ_RETRIES        3
+
 #define FT6336U_ADDR_THRESHOLD          0x80
 #define FT6336U_ADDR_FILTER_COE         0x85
 #define FT6336U_ADDR_CTRL               0x86
@@ -131,6 +136,7 @@ public:
     virtual ~FT6336U(); 
 
     void begin(void);
+    void setBus(I2CBus& bus, uint32_t clock = 0) { i2c.setBus(bus); i2c.setClock(clock); }
 
     uint8_t read_device_mode(void);
     void write_device_mode(DEVICE_MODE_Enum);
@@ -186,15 +192,25 @@ public:
 
     // Scan Function
     FT6336U_TouchPointType scan(void);
+    // Non-blocking scan: queue the burst, poll scan_busy(), then scan_result()
+    bool scan_start(void);
+    bool scan_busy(void) { return scanXfer.pending(); }
+    FT6336U_TouchPointType scan_result(void);
 
 private: 
     int8_t sda = -1; 
     int8_t scl = -1; 
     uint8_t rst_n = -1; 
     uint8_t int_n = -1; 
+    I2CDevice i2c = I2CDevice(I2C_ADDR_FT6336U); 
+    
+    I2CTransfer scanXfer; 
+    uint8_t scanBuf[FT6336U_SCAN_LEN]; 
     
     uint8_t readByte(uint8_t addr); 
+    uint16_t readCoord(uint8_t addr); 
     void writeByte(uint8_t addr, uint8_t data); 
+    void parseScan(const uint8_t *buf); 
 
     FT6336U_TouchPointType touchPoint; 
 }; 
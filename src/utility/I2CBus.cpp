@@ -0,0 +1,353 @@
+#include "I2CBus.h"
+
+#ifdef I2C_BUS_STATS
+#define I2C_STATS_START()                       uint32_t statsStart = micros()
+#define I2C_STATS_RECORD(addr, wr, rd, result)  stats.record(addr, site, wr, rd, result, micros() - statsStart)
+#else
+#define I2C_STATS_START()                       do {} while (0)
+#define I2C_STATS_RECORD(addr, wr, rd, result)  do {} while (0)
+#endif
+
+I2CBus::I2CBus(TwoWire& wire)
+  : port(wire), started(false), defaultClock(I2C_BUS_DEFAULT_CLOCK), currentClock(0),
+    queue(NULL), asyncTask(NULL), deferredCount(0) {
+  mutex = xSemaphoreCreateRecursiveMutex();
+#ifdef I2C_BUS_STATS
+  site = NULL;
+#endif
+}
+
+I2CBus& I2CBus::get(TwoWire& wire) {
+  if (&wire == &Wire1) {
+    static I2CBus bus1(Wire1);
+    return bus1;
+  }
+  static I2CBus bus0(Wire);
+  return bus0;
+}
+
+/**
+  * @brief  Start the port once, whichever driver gets there first
+  * @param  sda：SDA pin, -1 for the board default
+  * @param  scl：SCL pin, -1 for the board default
+  * @param  frequency：Default SCL frequency in Hz
+  * @retval true if the port is running
+  */
+bool I2CBus::begin(int sda, int scl, uint32_t frequency) {
+  Lock guard(*this);
+
+  if (started)
+    return true;
+
+  defaultClock = frequency;
+  started = port.begin(sda, scl, frequency);
+  currentClock = started ? frequency : 0;
+  return started;
+}
+
+bool I2CBus::lock(TickType_t timeout) {
+  return xSemaphoreTakeRecursive(mutex, timeout) == pdTRUE;
+}
+
+void I2CBus::unlock(void) {
+  xSemaphoreGiveRecursive(mutex);
+}
+
+/**
+  * @brief  Start the port if needed and switch to the device's clock
+  * @param  clock：SCL frequency in Hz, 0 for the bus default
+  * @retval none
+  */
+void I2CBus::prepare(uint32_t clock) {
+  if (!started)
+    begin();
+
+  if (clock == 0)
+    clock = defaultClock;
+  if (clock != currentClock) {
+    port.setClock(clock);
+    currentClock = clock;
+  }
+}
+
+/**
+  * @brief  Read len bytes in requests no larger than the Wire buffer
+  * @retval Number of bytes actually read
+  */
+size_t I2CBus::requestChunks(uint8_t addr, uint8_t* dest, size_t len) {
+  size_t done = 0;
+
+  while (done < len) {
+    uint8_t want = (len - done > I2C_BUS_CHUNK) ? I2C_BUS_CHUNK : (uint8_t)(len - done);
+    uint8_t got = port.requestFrom(addr, want);
+    for (uint8_t i = 0; i < got; i++)
+      dest[done + i] = port.read();
+    done += got;
+    if (got != want)
+      break;
+  }
+  return done;
+}
+
+bool I2CBus::write(uint8_t addr, const uint8_t* data, size_t len, uint32_t clock) {
+  Lock guard(*this);
+  I2C_STATS_START();
+
+  prepare(clock);
+  port.beginTransmission(addr);
+  port.write(data, len);
+  uint8_t err = port.endTransmission();
+  I2C_STATS_RECORD(addr, len, 0, i2cStatsWriteResult(err));
+  return err == 0;
+}
+
+bool I2CBus::writeReg(uint8_t addr, uint8_t reg, uint8_t value, uint32_t clock) {
+  uint8_t buf[2] = { reg, value };
+
+  return write(addr, buf, 2, clock);
+}
+
+bool I2CBus::writeRegs(uint8_t addr, uint8_t reg, const uint8_t* data, size_t len, uint32_t clock) {
+  Lock guard(*this);
+  I2C_STATS_START();
+
+  prepare(clock);
+  port.beginTransmission(addr);
+  port.write(reg);
+  port.write(data, len);
+  uint8_t err = port.endTransmission();
+  I2C_STATS_RECORD(addr, len + 1, 0, i2cStatsWriteResult(err));
+  return err == 0;
+}
+
+size_t I2CBus::read(uint8_t addr, uint8_t* dest, size_t len, uint32_t clock) {
+  Lock guard(*this);
+  I2C_STATS_START();
+
+  prepare(clock);
+  size_t got = requestChunks(addr, dest, len);
+  I2C_STATS_RECORD(addr, 0, got, i2cStatsReadResult(got, len));
+  return got;
+}
+
+bool I2CBus::readReg(uint8_t addr, uint8_t reg, uint8_t* value, uint32_t clock) {
+  return readRegs(addr, reg, value, 1, clock) == 1;
+}
+
+size_t I2CBus::readRegs(uint8_t addr, uint8_t reg, uint8_t* dest, size_t len, uint32_t clock) {
+  return writeThenRead(addr, &reg, 1, dest, len, clock, true);
+}
+
+size_t I2CBus::writeThenRead(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen,
+                             uint32_t clock, bool repeatedStart) {
+  Lock guard(*this);
+  I2C_STATS_START();
+
+  prepare(clock);
+  port.beginTransmission(addr);
+  port.write(tx, txLen);
+  uint8_t err = port.endTransmission(!repeatedStart);
+  //ESP32 reports the pending repeated start as I2C_ERROR_CONTINUE (7) on older cores
+  if (err != 0 && err != 7) {
+    I2C_STATS_RECORD(addr, txLen, 0, i2cStatsWriteResult(err));
+    return 0;
+  }
+  size_t got = requestChunks(addr, rx, rxLen);
+  I2C_STATS_RECORD(addr, txLen, got, i2cStatsReadResult(got, rxLen));
+  return got;
+}
+
+bool I2CDevice::submit(I2CTransfer* xfer, const uint8_t* tx, uint8_t txLen, uint8_t* rx, size_t rxLen,
+                       uint32_t gapUs, I2CTransferCallback callback, void* arg) {
+  if (!getBus().submittable(xfer) || txLen > I2C_XFER_TX_MAX)
+    return false;
+
+  xfer->addr = addr;
+  xfer->clock = clock;
+  memcpy(xfer->tx, tx, txLen);
+  xfer->txLen = txLen;
+  xfer->rx = rx;
+  xfer->rxLen = rxLen;
+  xfer->gapUs = gapUs;
+  xfer->callback = callback;
+  xfer->arg = arg;
+  return getBus().submit(xfer);
+}
+
+bool I2CBus::startAsync(UBaseType_t priority, BaseType_t core) {
+  Lock guard(*this);
+
+  if (asyncTask != NULL)
+    return true;
+
+  if (queue == NULL)
+    queue = xQueueCreate(I2C_ASYNC_QUEUE_DEPTH, sizeof(I2CTransfer*));
+  if (queue == NULL)
+    return false;
+
+  if (xTaskCreatePinnedToCore(asyncLoop, "i2cbus", I2C_ASYNC_STACK, this, priority, &asyncTask, core) != pdPASS) {
+    asyncTask = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool I2CBus::submittable(I2CTransfer* xfer) {
+  if (xfer->status == I2C_XFER_QUEUED || xfer->status == I2C_XFER_BUSY)
+    return false;
+  return !xfer->inCallback || xTaskGetCurrentTaskHandle() == asyncTask;
+}
+
+bool I2CBus::submit(I2CTransfer* xfer) {
+  if (!submittable(xfer))
+    return false;
+  if (asyncTask == NULL && !startAsync())
+    return false;
+
+  xfer->received = 0;
+  xfer->status = I2C_XFER_QUEUED;
+  if (xQueueSend(queue, &xfer, 0) != pdTRUE) {
+    xfer->status = I2C_XFER_IDLE;
+    return false;
+  }
+  return true;
+}
+
+bool I2CBus::wait(I2CTransfer* xfer, TickType_t timeout) {
+  if (xfer->doneSem == NULL && (xfer->doneSem = xSemaphoreCreateBinary()) == NULL)
+    return false;
+
+  xfer->waiting = 1;
+  __sync_synchronize();
+  if (xfer->pending() && xSemaphoreTake(xfer->doneSem, timeout) == pdTRUE)
+    return xfer->status == I2C_XFER_DONE;
+
+  //Done before we blocked, or timed out. If finish() has claimed the waiter
+  //anyway its give is on the way: take it, or the next wait() returns early
+  if (!__sync_bool_compare_and_swap(&xfer->waiting, 1, 0))
+    xSemaphoreTake(xfer->doneSem, portMAX_DELAY);
+  return xfer->status == I2C_XFER_DONE;
+}
+
+/**
+  * @brief  Bus task: run queued transfers back to back, and issue the read
+  *         phase of parked transfers once their gap has elapsed
+  * @param  arg：The I2CBus
+  * @retval none
+  */
+void I2CBus::asyncLoop(void* arg) {
+  I2CBus* bus = (I2CBus*)arg;
+  I2CTransfer* xfer;
+
+  for (;;) {
+    TickType_t timeout = portMAX_DELAY;
+    uint32_t now = micros();
+
+    for (uint8_t i = 0; i < bus->deferredCount; i++) {
+      int32_t left = (int32_t)(bus->deferred[i]->due - now);
+      TickType_t ticks = left <= 0 ? 0 : (left + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+      if (ticks < timeout)
+        timeout = ticks;
+    }
+
+    if (xQueueReceive(bus->queue, &xfer, timeout) == pdTRUE) {
+      I2C_STATS_SITE(*bus, xfer->site);
+      bus->execute(xfer);
+    }
+
+    now = micros();
+    for (uint8_t i = 0; i < bus->deferredCount; ) {
+      xfer = bus->deferred[i];
+      if ((int32_t)(xfer->due - now) > 0) {
+        i++;
+        continue;
+      }
+      bus->deferred[i] = bus->deferred[--bus->deferredCount];
+      I2C_STATS_SITE(*bus, xfer->site);
+      bus->readPhase(xfer);
+    }
+  }
+}
+
+void I2CBus::execute(I2CTransfer* xfer) {
+  xfer->status = I2C_XFER_BUSY;
+
+  if (xfer->rxLen == 0) {
+    finish(xfer, write(xfer->addr, xfer->tx, xfer->txLen, xfer->clock));
+    return;
+  }
+  if (xfer->txLen == 0) {
+    readPhase(xfer);
+    return;
+  }
+  if (xfer->gapUs == 0) {
+    xfer->received = writeThenRead(xfer->addr, xfer->tx, xfer->txLen, xfer->rx, xfer->rxLen, xfer->clock);
+    finish(xfer, xfer->received == xfer->rxLen);
+    return;
+  }
+
+  if (!write(xfer->addr, xfer->tx, xfer->txLen, xfer->clock)) {
+    finish(xfer, false);
+    return;
+  }
+  if (deferredCount == I2C_ASYNC_DEFERRED_MAX) {
+    //No room to park it: wait out the gap here rather than fail
+    delayMicroseconds(xfer->gapUs);
+    readPhase(xfer);
+    return;
+  }
+  xfer->due = micros() + xfer->gapUs;
+  deferred[deferredCount++] = xfer;
+}
+
+void I2CBus::readPhase(I2CTransfer* xfer) {
+  xfer->received = read(xfer->addr, xfer->rx, xfer->rxLen, xfer->clock);
+  finish(xfer, xfer->received == xfer->rxLen);
+}
+
+void I2CBus::finish(I2CTransfer* xfer, bool ok) {
+  //The callback sees the result, but the descriptor stays pending() until it
+  //returns, so no other task can resubmit or free it (or rx) underneath it
+  xfer->inCallback = true;
+  xfer->status = ok ? I2C_XFER_DONE : I2C_XFER_ERROR;
+  if (xfer->callback)
+    xfer->callback(xfer, xfer->arg);
+  __sync_synchronize();
+  xfer->inCallback = false;
+  __sync_synchronize();
+
+  //Claimed atomically against a wait() that is giving up
+  if (__sync_lock_test_and_set(&xfer->waiting, 0))
+    xSemaphoreGive(xfer->doneSem);
+}
+
+bool I2CBus::getStats(i2c_stats_snapshot_t* snapshot) {
+#ifdef I2C_BUS_STATS
+  Lock guard(*this);
+  stats.snapshot(snapshot);
+  return true;
+#else
+  (void)snapshot;
+  return false;
+#endif
+}
+
+void I2CBus::resetStats(void) {
+#ifdef I2C_BUS_STATS
+  Lock guard(*this);
+  stats.reset();
+#endif
+}
+
+void I2CBus::dumpStats(Print& out) {
+#ifdef I2C_BUS_STATS
+  static i2c_stats_snapshot_t snapshot;
+  Lock guard(*this);
+
+  //The static snapshot is only used with the bus held
+  stats.snapshot(&snapshot);
+  I2CStats::dump(snapshot, out);
+#else
+  (void)out;
+#endif
+}
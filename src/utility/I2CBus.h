@@ -0,0 +1,332 @@
+#ifndef _I2CBUS_H_
+#define _I2CBUS_H_
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "I2CStats.h"
+
+/*
+ * Shared I2C bus.
+ *
+ * One I2CBus owns one TwoWire port. Every transaction (address phase, data,
+ * stop) runs with the bus mutex held, so drivers called from tasks on either
+ * core never interleave on the wire. The mutex is recursive: a driver that
+ * needs several transactions back to back (e.g. read the FIFO pointers, then
+ * burst the FIFO) can hold an I2CBus::Lock around them.
+ *
+ * Each transaction carries the SCL frequency of its device; the bus only calls
+ * setClock() when it differs from the one currently programmed. A clock of 0
+ * means the bus default given to begin().
+ *
+ * Not usable from an ISR.
+ */
+
+#define I2C_BUS_DEFAULT_CLOCK       400000
+
+#ifdef I2C_BUFFER_LENGTH
+#define I2C_BUS_CHUNK               I2C_BUFFER_LENGTH
+#else
+#define I2C_BUS_CHUNK               32
+#endif
+
+#define I2C_ASYNC_QUEUE_DEPTH       16          //Transfers waiting for the bus task
+#define I2C_ASYNC_DEFERRED_MAX      8           //Transfers parked between write and read
+#define I2C_ASYNC_PRIORITY          5
+#define I2C_ASYNC_STACK             3072
+#define I2C_XFER_TX_MAX             8
+
+/*
+ * Name the driver call site the enclosed transactions are accounted to,
+ * see I2CStats.h. The site holds the bus for the rest of the scope, so keep
+ * delays out of it.
+ * I2C_STATS_XFER_SITE does the same for an asynchronous transfer.
+ */
+#ifdef I2C_BUS_STATS
+#define I2C_STATS_SITE(bus, name)         I2CBus::Site i2cStatsSite((bus), (name))
+#define I2C_STATS_XFER_SITE(xfer, name)   ((xfer)->site = (name))
+#else
+#define I2C_STATS_SITE(bus, name)         do {} while (0)
+#define I2C_STATS_XFER_SITE(xfer, name)   do {} while (0)
+#endif
+
+typedef enum {
+  I2C_XFER_IDLE = 0,
+  I2C_XFER_QUEUED,
+  I2C_XFER_BUSY,
+  I2C_XFER_DONE,
+  I2C_XFER_ERROR
+} i2c_xfer_status_t;
+
+struct I2CTransfer;
+typedef void (*I2CTransferCallback)(I2CTransfer* xfer, void* arg);
+
+/*
+ * One asynchronous transaction: write tx, then read rxLen bytes into rx.
+ *
+ * With gapUs == 0 the read follows with a repeated start. Otherwise the bus
+ * is released after the write and the read is issued gapUs later, which is
+ * how "start conversion, fetch result" sensors are driven without blocking
+ * anybody. Either phase may be empty.
+ *
+ * The caller owns the descriptor and rx; both must stay valid until
+ * pending() is false, which is only after the callback has returned. The
+ * callback runs on the bus task and already sees the final status; it may
+ * resubmit the descriptor or issue blocking I2CBus calls, but must not wait()
+ * on the bus.
+ */
+struct I2CTransfer {
+  uint8_t addr;
+  uint32_t clock;
+  uint8_t tx[I2C_XFER_TX_MAX];
+  uint8_t txLen;
+  uint8_t* rx;
+  size_t rxLen;
+  uint32_t gapUs;
+  I2CTransferCallback callback;
+  void* arg;
+
+  volatile i2c_xfer_status_t status;
+  volatile bool inCallback;   //status is final, but the callback is still running
+  size_t received;
+
+  //Owned by the bus
+  uint32_t due;
+  volatile uint8_t waiting;      //A wait() is blocked on doneSem
+  SemaphoreHandle_t doneSem;     //Created by the first wait()
+#ifdef I2C_BUS_STATS
+  const char* site;
+#endif
+
+  I2CTransfer() : addr(0), clock(0), txLen(0), rx(NULL), rxLen(0), gapUs(0), callback(NULL), arg(NULL),
+                  status(I2C_XFER_IDLE), inCallback(false), received(0), due(0), waiting(0), doneSem(NULL) {
+#ifdef I2C_BUS_STATS
+    site = NULL;
+#endif
+  }
+  ~I2CTransfer() {
+    if (doneSem != NULL)
+      vSemaphoreDelete(doneSem);
+  }
+  bool pending(void) const { return status == I2C_XFER_QUEUED || status == I2C_XFER_BUSY || inCallback; }
+  bool done(void) const { return status == I2C_XFER_DONE; }
+};
+
+class I2CBus {
+  public:
+    /**
+      * @brief  Bus owning the given port; the ESP32 only has Wire and Wire1
+      */
+    static I2CBus& get(TwoWire& wire = Wire);
+
+    /**
+      * @brief  Start the port. Only the first call configures the pins,
+      *         later calls (from other drivers) are no-ops. Transactions on a
+      *         bus nobody started begin it with the default pins.
+      * @param  sda：SDA pin, -1 for the board default
+      * @param  scl：SCL pin, -1 for the board default
+      * @param  frequency：Default SCL frequency in Hz
+      * @retval true if the port is running
+      */
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = I2C_BUS_DEFAULT_CLOCK);
+    bool isStarted(void) { return started; }
+
+    bool lock(TickType_t timeout = portMAX_DELAY);
+    void unlock(void);
+
+    /* Scoped lock */
+    class Lock {
+      public:
+        explicit Lock(I2CBus& bus) : bus(bus) { bus.lock(); }
+        ~Lock() { bus.unlock(); }
+      private:
+        I2CBus& bus;
+        Lock(const Lock&);
+        Lock& operator=(const Lock&);
+    };
+
+    TwoWire& wire(void) { return port; }
+    uint32_t getDefaultClock(void) { return defaultClock; }
+
+    /**
+      * @brief  Plain write
+      * @param  addr：7 bit device address
+      * @param  data：Bytes to send
+      * @param  len：Number of bytes, at most I2C_BUS_CHUNK
+      * @param  clock：SCL frequency for this device, 0 for the bus default
+      * @retval true if the device acknowledged everything
+      */
+    bool write(uint8_t addr, const uint8_t* data, size_t len, uint32_t clock = 0);
+
+    /**
+      * @brief  Write one register, or consecutive registers from reg on
+      */
+    bool writeReg(uint8_t addr, uint8_t reg, uint8_t value, uint32_t clock = 0);
+    bool writeRegs(uint8_t addr, uint8_t reg, const uint8_t* data, size_t len, uint32_t clock = 0);
+
+    /**
+      * @brief  Plain read, split into I2C_BUS_CHUNK sized requests
+      * @retval Number of bytes actually read
+      */
+    size_t read(uint8_t addr, uint8_t* dest, size_t len, uint32_t clock = 0);
+
+    /**
+      * @brief  Read one register
+      * @param  value：Receives the register value
+      * @retval true on success
+      */
+    bool readReg(uint8_t addr, uint8_t reg, uint8_t* value, uint32_t clock = 0);
+
+    /**
+      * @brief  Set the register pointer, then read len bytes with a repeated
+      *         start. Reads longer than I2C_BUS_CHUNK continue with further
+      *         requests without re-addressing, which suits both auto-increment
+      *         registers and FIFO data registers.
+      * @retval Number of bytes actually read
+      */
+    size_t readRegs(uint8_t addr, uint8_t reg, uint8_t* dest, size_t len, uint32_t clock = 0);
+
+    /**
+      * @brief  Write tx, then read rx in the same locked transaction
+      * @param  repeatedStart：false to send a stop between the two phases
+      * @retval Number of bytes read, 0 if the write was not acknowledged
+      */
+    size_t writeThenRead(uint8_t addr, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen,
+                         uint32_t clock = 0, bool repeatedStart = true);
+
+    /**
+      * @brief  Start the bus task executing submitted transfers. Done
+      *         automatically with the defaults on the first submit().
+      * @param  priority：FreeRTOS priority of the bus task
+      * @param  core：Core to pin it to, tskNO_AFFINITY for either
+      * @retval true if the task is running
+      */
+    bool startAsync(UBaseType_t priority = I2C_ASYNC_PRIORITY, BaseType_t core = tskNO_AFFINITY);
+
+    /**
+      * @brief  Queue a transfer for the bus task without blocking
+      * @retval false if the transfer is still pending or the queue is full
+      */
+    bool submit(I2CTransfer* xfer);
+
+    /**
+      * @brief  Whether submit() would accept xfer: it is not pending, or it
+      *         is being resubmitted from its own callback on the bus task
+      */
+    bool submittable(I2CTransfer* xfer);
+
+    /**
+      * @brief  Block the calling task until the transfer completes. Waits on
+      *         a semaphore of the transfer, so the caller's task notifications
+      *         are left alone; one waiter per transfer.
+      * @retval true if it completed successfully within the timeout
+      */
+    bool wait(I2CTransfer* xfer, TickType_t timeout = portMAX_DELAY);
+
+    /**
+      * @brief  Copy the transaction accounting, see I2CStats.h
+      * @retval false when built without I2C_BUS_STATS
+      */
+    bool getStats(i2c_stats_snapshot_t* snapshot);
+    void resetStats(void);
+    /**
+      * @brief  getStats() and I2CStats::dump() in one, into a static snapshot
+      */
+    void dumpStats(Print& out);
+
+#ifdef I2C_BUS_STATS
+    /* Scoped call site name, taken with the bus held */
+    class Site {
+      public:
+        Site(I2CBus& bus, const char* name) : bus(bus) { bus.lock(); prev = bus.site; bus.site = name; }
+        ~Site() { bus.site = prev; bus.unlock(); }
+      private:
+        I2CBus& bus;
+        const char* prev;
+        Site(const Site&);
+        Site& operator=(const Site&);
+    };
+#endif
+
+  private:
+    explicit I2CBus(TwoWire& wire);
+    I2CBus(const I2CBus&);
+    I2CBus& operator=(const I2CBus&);
+
+    void prepare(uint32_t clock);
+    size_t requestChunks(uint8_t addr, uint8_t* dest, size_t len);
+
+    static void asyncLoop(void* arg);
+    void execute(I2CTransfer* xfer);
+    void readPhase(I2CTransfer* xfer);
+    void finish(I2CTransfer* xfer, bool ok);
+
+    TwoWire& port;
+    SemaphoreHandle_t mutex;
+    bool started;
+    uint32_t defaultClock;
+    uint32_t currentClock;
+
+    QueueHandle_t queue;
+    TaskHandle_t asyncTask;
+    I2CTransfer* deferred[I2C_ASYNC_DEFERRED_MAX];
+    uint8_t deferredCount;
+
+#ifdef I2C_BUS_STATS
+    I2CStats stats;
+    const char* site;
+#endif
+};
+
+/*
+ * One device on a shared bus: address and SCL frequency bound to the
+ * I2CBus primitives.
+ */
+class I2CDevice {
+  public:
+    I2CDevice(uint8_t address, uint32_t clock = 0) : bus(NULL), addr(address), clock(clock) {}
+    I2CDevice(uint8_t address, uint32_t clock, I2CBus& bus) : bus(&bus), addr(address), clock(clock) {}
+
+    void setBus(I2CBus& bus) { this->bus = &bus; }
+    I2CBus& getBus(void) { return bus ? *bus : I2CBus::get(); }
+    void setAddress(uint8_t address) { addr = address; }
+    uint8_t getAddress(void) { return addr; }
+    void setClock(uint32_t clock) { this->clock = clock; }
+    uint32_t getClock(void) { return clock; }
+
+    bool write(const uint8_t* data, size_t len) { return getBus().write(addr, data, len, clock); }
+    bool writeReg(uint8_t reg, uint8_t value) { return getBus().writeReg(addr, reg, value, clock); }
+    bool writeRegs(uint8_t reg, const uint8_t* data, size_t len) { return getBus().writeRegs(addr, reg, data, len, clock); }
+    size_t read(uint8_t* dest, size_t len) { return getBus().read(addr, dest, len, clock); }
+    bool readReg(uint8_t reg, uint8_t* value) { return getBus().readReg(addr, reg, value, clock); }
+    size_t readRegs(uint8_t reg, uint8_t* dest, size_t len) { return getBus().readRegs(addr, reg, dest, len, clock); }
+    size_t writeThenRead(const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen, bool repeatedStart = true) {
+      return getBus().writeThenRead(addr, tx, txLen, rx, rxLen, clock, repeatedStart);
+    }
+
+    /**
+      * @brief  Fill in and queue an asynchronous transfer to this device
+      * @param  xfer：Caller owned descriptor
+      * @param  tx：Bytes to write first, at most I2C_XFER_TX_MAX
+      * @param  rx：Buffer for the read phase, NULL for a plain write
+      * @param  gapUs：0 for a repeated start read, else delay between write and read
+      * @retval true if queued
+      */
+    bool submit(I2CTransfer* xfer, const uint8_t* tx, uint8_t txLen, uint8_t* rx = NULL, size_t rxLen = 0,
+                uint32_t gapUs = 0, I2CTransferCallback callback = NULL, void* arg = NULL);
+    bool submitReadRegs(I2CTransfer* xfer, uint8_t reg, uint8_t* dest, size_t len,
+                        I2CTransferCallback callback = NULL, void* arg = NULL) {
+      return submit(xfer, &reg, 1, dest, len, 0, callback, arg);
+    }
+    bool wait(I2CTransfer* xfer, TickType_t timeout = portMAX_DELAY) { return getBus().wait(xfer, timeout); }
+
+  private:
+    I2CBus* bus;            //NULL until first use: the default bus is looked up lazily
+    uint8_t addr;
+    uint32_t clock;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "I2CStats.h"
+
+void I2CStats::reset(void) {
+  memset(&table, 0, sizeof(table));
+  since = micros();
+}
+
+void I2CStats::add(i2c_stats_counters_t* c, size_t written, size_t read, i2c_stats_result_t result, uint32_t us) {
+  uint8_t bucket = us ? 31 - __builtin_clz(us) : 0;
+
+  c->transactions++;
+  c->bytesWritten += written;
+  c->bytesRead += read;
+  if (result == I2C_STATS_NACK)
+    c->nacks++;
+  else if (result == I2C_STATS_ERROR)
+    c->errors++;
+  c->totalUs += us;
+  if (us > c->maxUs)
+    c->maxUs = us;
+  c->histogram[bucket < I2C_STATS_BUCKETS ? bucket : I2C_STATS_BUCKETS - 1]++;
+}
+
+/**
+  * @brief  Account one transaction
+  * @param  site：Call site name, NULL outside any I2C_STATS_SITE()
+  * @param  written：Bytes sent, register address included
+  * @param  read：Bytes received
+  * @param  us：Time from taking the bus to the end of the transfer
+  * @retval none
+  */
+void I2CStats::record(uint8_t addr, const char* site, size_t written, size_t read,
+                      i2c_stats_result_t result, uint32_t us) {
+  uint8_t i;
+
+  add(&table.total, written, read, result, us);
+
+  for (i = 0; i < table.deviceCount && table.devices[i].addr != addr; i++)
+    ;
+  if (i == table.deviceCount && i < I2C_STATS_MAX_DEVICES)
+    table.devices[table.deviceCount++].addr = addr;
+  if (i < table.deviceCount)
+    add(&table.devices[i].counters, written, read, result, us);
+  else
+    table.dropped++;
+
+  //Sites are string literals, so the pointer identifies them
+  for (i = 0; i < table.siteCount && table.sites[i].site != site; i++)
+    ;
+  if (i == table.siteCount && i < I2C_STATS_MAX_SITES)
+    table.sites[table.siteCount++].site = site;
+  if (i < table.siteCount)
+    add(&table.sites[i].counters, written, read, result, us);
+  else
+    table.dropped++;
+}
+
+void I2CStats::snapshot(i2c_stats_snapshot_t* out) {
+  *out = table;
+  out->elapsedUs = micros() - since;
+}
+
+void I2CStats::dumpRow(Print& out, const char* kind, const char* key, const i2c_stats_counters_t& c) {
+  const uint32_t values[] = { c.transactions, c.bytesWritten, c.bytesRead, c.nacks, c.errors, c.totalUs, c.maxUs };
+
+  out.print(kind);
+  out.print(',');
+  out.print(key);
+  for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    out.print(',');
+    out.print((unsigned long)values[i]);
+  }
+  for (uint8_t b = 0; b < I2C_STATS_BUCKETS; b++) {
+    out.print(',');
+    out.print((unsigned long)c.histogram[b]);
+  }
+  out.println();
+}
+
+void I2CStats::dump(const i2c_stats_snapshot_t& snap, Print& out) {
+  char key[8];
+
+  //Histogram columns are named by their upper bound in us, the last one is open
+  out.print("kind,key,transactions,bytes_written,bytes_read,nacks,errors,total_us,max_us");
+  for (uint8_t b = 0; b < I2C_STATS_BUCKETS - 1; b++) {
+    out.print(",lt");
+    out.print(2UL << b);
+  }
+  out.print(",ge");
+  out.println(1UL << (I2C_STATS_BUCKETS - 1));
+
+  for (uint8_t i = 0; i < snap.deviceCount; i++) {
+    snprintf(key, sizeof(key), "0x%02X", snap.devices[i].addr);
+    dumpRow(out, "dev", key, snap.devices[i].counters);
+  }
+  for (uint8_t i = 0; i < snap.siteCount; i++)
+    dumpRow(out, "site", snap.sites[i].site ? snap.sites[i].site : "-", snap.sites[i].counters);
+  dumpRow(out, "total", "-", snap.total);
+
+  out.print("elapsed_us,");
+  out.print((unsigned long)snap.elapsedUs);
+  out.print(",dropped,");
+  out.println((unsigned long)snap.dropped);
+}
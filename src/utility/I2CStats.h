@@ -0,0 +1,107 @@
+#ifndef _I2CSTATS_H_
+#define _I2CSTATS_H_
+
+#include <Arduino.h>
+
+/*
+ * Optional I2C accounting.
+ *
+ * With I2C_BUS_STATS defined every I2CBus primitive (write, read,
+ * writeThenRead, ...) is counted once, per device address and per call site:
+ * bytes moved, NACKs, other errors, and the time from taking the bus to the
+ * end of the transfer in a log2 histogram. Call sites are named with
+ * I2C_STATS_SITE() in the driver; transactions outside any site count as "-".
+ *
+ * Without I2C_BUS_STATS the hooks expand to nothing and I2CBus carries no
+ * extra state. The define has to be the same for the whole build, so set it
+ * in the build flags (-DI2C_BUS_STATS) or uncomment it below.
+ */
+
+//#define I2C_BUS_STATS
+
+#define I2C_STATS_MAX_DEVICES       16
+#define I2C_STATS_MAX_SITES         16
+#define I2C_STATS_BUCKETS           16          //Bucket i: [2^i, 2^(i+1)) us, bucket 0 also holds 0 us
+
+typedef enum {
+  I2C_STATS_OK = 0,
+  I2C_STATS_NACK,                               //Address or data not acknowledged
+  I2C_STATS_ERROR                               //Bus error, timeout or short read
+} i2c_stats_result_t;
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t bytesWritten;
+  uint32_t bytesRead;
+  uint32_t nacks;
+  uint32_t errors;
+  uint32_t totalUs;
+  uint32_t maxUs;
+  uint32_t histogram[I2C_STATS_BUCKETS];
+} i2c_stats_counters_t;
+
+typedef struct {
+  uint8_t addr;
+  i2c_stats_counters_t counters;
+} i2c_stats_device_t;
+
+typedef struct {
+  const char* site;
+  i2c_stats_counters_t counters;
+} i2c_stats_site_t;
+
+// About 3 KB: keep snapshots static rather than on a task stack
+typedef struct {
+  uint32_t elapsedUs;                           //Since the last reset
+  uint32_t dropped;                             //Transactions that found their table full
+  i2c_stats_counters_t total;
+  uint8_t deviceCount;
+  i2c_stats_device_t devices[I2C_STATS_MAX_DEVICES];
+  uint8_t siteCount;
+  i2c_stats_site_t sites[I2C_STATS_MAX_SITES];
+} i2c_stats_snapshot_t;
+
+/* Map Wire results onto i2c_stats_result_t */
+inline i2c_stats_result_t i2cStatsWriteResult(uint8_t err) {
+  //7 is the pending repeated start of older ESP32 cores
+  if (err == 0 || err == 7)
+    return I2C_STATS_OK;
+  return (err == 2 || err == 3) ? I2C_STATS_NACK : I2C_STATS_ERROR;
+}
+
+inline i2c_stats_result_t i2cStatsReadResult(size_t got, size_t wanted) {
+  if (got == wanted)
+    return I2C_STATS_OK;
+  return got == 0 ? I2C_STATS_NACK : I2C_STATS_ERROR;
+}
+
+/*
+ * The tables behind I2C_BUS_STATS. Not thread safe by itself: I2CBus only
+ * touches it with the bus mutex held.
+ */
+class I2CStats {
+  public:
+    I2CStats() { reset(); }
+
+    void record(uint8_t addr, const char* site, size_t written, size_t read,
+                i2c_stats_result_t result, uint32_t us);
+    void reset(void);
+    void snapshot(i2c_stats_snapshot_t* out);
+
+    /**
+      * @brief  Print a snapshot as CSV: a header line, then one "dev", "site"
+      *         and "total" row each with the counters and histogram buckets
+      * @param  out：Serial, a File, ...
+      * @retval none
+      */
+    static void dump(const i2c_stats_snapshot_t& snap, Print& out);
+
+  private:
+    uint32_t since;
+    i2c_stats_snapshot_t table;
+
+    static void add(i2c_stats_counters_t* c, size_t written, size_t read, i2c_stats_result_t result, uint32_t us);
+    static void dumpRow(Print& out, const char* kind, const char* key, const i2c_stats_counters_t& c);
+};
+
+#endif
@@ -7,10 +7,9 @@
   */
 void IP5306::readByte(uint8_t address)
 {
-	Wire.beginTransmission(IP5306_ADDR);
-	Wire.write(address);
-  if(Wire.endTransmission() == 0 && Wire.requestFrom(IP5306_CHECK_POWER, 1)) 
-    data = Wire.read() & 0xF0;
+	uint8_t value;
+	if(i2c.readReg(address, &value))
+		data = value;
 }
 
 /**
@@ -21,13 +20,14 @@ void IP5306::readByte(uint8_t address)
 uint8_t IP5306::Ip5306_Check_Power(void)
 {
     readByte(IP5306_CHECK_POWER);
-    if(get_data() == 0x00)
+    uint8_t level = get_data() & 0xF0;
+    if(level == 0x00)
         return 100;
-    else if(get_data() == 0x80)
+    else if(level == 0x80)
         return 75;
-    else if(get_data() == 0xC0)
+    else if(level == 0xC0)
         return 50;
-    else if(get_data() == 0xE0)
+    else if(level == 0xE0)
         return 25;
     else
         return 0;
@@ -6,6 +6,7 @@
 #include "freertos/task.h"
 #include <Wire.h>
 #include <Arduino.h>
+#include "I2CBus.h"
 
 #define IP5306_I2C_SCL_IO            4
 #define IP5306_I2C_SDA_IO            13
@@ -20,8 +21,10 @@
 class IP5306{
 	private:
 		uint8_t data;
+		I2CDevice i2c;
 	public:
-		IP5306(){}
+		IP5306() : data(0), i2c(IP5306_ADDR) {}
+		void setBus(I2CBus& bus, uint32_t clock = 0) { i2c.setBus(bus); i2c.setClock(clock); }
 		uint8_t get_data(void){return data;}
 		uint8_t Ip5306_Check_Power(void);
 		void readByte(uint8_t address);
@@ -18,6 +18,8 @@
 #endif
 
 #include <Wire.h>
+#include "I2CBus.h"
+#include "SampleRing.h"
 #include "heartRate.h"
 
 #define MAX30105_ADDRESS          0x57 //7-bit I2C Address
@@ -27,6 +29,9 @@
 #define I2C_SPEED_FAST            400000
 
 //Define the size of the I2C buffer based on the platform the user has
+//ESP32's Wire.h already defines it (128 bytes), which takes precedence
+#ifndef I2C_BUFFER_LENGTH
+
 #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
 
   //I2C_BUFFER_LENGTH is defined in Wire.H
@@ -44,9 +49,39 @@
 
 #endif
 
+#endif
+
+#define MAX30102_FIFO_DEPTH       32 //Samples the hardware FIFO holds
+#define MAX30102_STREAM_DEPTH     64 //Samples buffered between the A_FULL reader task and the consumer
+#define MAX30102_STREAM_RETRY_MS  5  //Reader task re-polls this soon when a drain left samples behind
+#define MAX30102_RATE_SIZE         4 //Beats averaged by get_avgBPM()
+
+//One FIFO sample, 18 bit per channel; channels that are not active read 0
+typedef struct {
+  uint32_t red;
+  uint32_t ir;
+  uint32_t green;
+} max30102_sample_t;
+
+#define MAX30102_SPO2_WINDOW     100 //Samples per SpO2 estimate, as get_ESPO2()
+
+//Fixed point state of calSpO2(), owned by the caller, one per sensor.
+//SpO2 values are in 0.1 %.
+typedef struct {
+  int32_t aveRed;       //DC levels by low pass filter, Q8
+  int32_t aveIR;
+  uint64_t sumRedRms;   //Square sums of the Q4 AC components, so Q8
+  uint64_t sumIRRms;
+  uint16_t count;       //Samples in the current window
+  int16_t SpO2;         //Raw SpO2 of the last window
+  int16_t ESpO2;        //Low pass filtered SpO2
+} max30102_spo2_t;
+
 class MAX30102 {
  public: 
-  MAX30102(){}
+  MAX30102() : _i2c(MAX30105_ADDRESS), checkRunning(false), checkSamples(0), fifoOverflows(0),
+               streaming(false), streamPin(0), streamTask(NULL), streamConsumer(NULL),
+               rateSpot(0), rates(), lastBeat(0), espo2Count(0), activeLEDs(0) {}
 
   boolean begin(TwoWire &wirePort = Wire, uint32_t i2cSpeed = I2C_SPEED_STANDARD, uint8_t i2caddr = MAX30105_ADDRESS);
 
@@ -78,6 +113,20 @@ class MAX30102 {
   // Data Collection
 
   //Interrupts (page 13, 14)
+  uint8_t getINT1(void); //Returns the main interrupt group
+  void enableAFULL(void); //Enable/disable individual interrupts
+  void disableAFULL(void);
+
+  //Interrupt driven acquisition: A_FULL -> reader task -> sample ring.
+  //Between bursts no task polls the sensor, so the CPU is free to run other
+  //work or drop into automatic light sleep.
+  int startStream(uint8_t intPin, uint8_t freeSlots = 8, UBaseType_t priority = 5, BaseType_t core = tskNO_AFFINITY);
+  void stopStream(void);
+  void setStreamConsumer(TaskHandle_t task) { streamConsumer = task; } //Notified once per burst
+  bool readSample(max30102_sample_t *sample) { return (ring.pop(sample)); }
+  uint16_t readStream(max30102_sample_t *dest, uint16_t maxSamples);
+  uint32_t availableSamples(void) { return (ring.available()); }
+  uint32_t getStreamDrops(void) { return (ring.getOverruns()); } //Drained while the ring was full
 
   //FIFO Configuration (page 18)
   void setFIFOAverage(uint8_t samples);
@@ -87,12 +136,26 @@ class MAX30102 {
   
   //FIFO Reading
   uint16_t check(void); //Checks for new data and fills FIFO
+  bool startCheck(void); //Same as check() but runs on the bus task, returns at once
+  int16_t collectCheck(void); //-1 while startCheck() is running, else the number of new samples
   uint8_t available(void); //Tells caller how many new samples are available (head - tail)
   void nextSample(void); //Advances the tail of the sense array
   uint32_t getFIFORed(void); //Returns the FIFO sample pointed to by tail
   uint32_t getFIFOIR(void); //Returns the FIFO sample pointed to by tail
   uint32_t getFIFOGreen(void); //Returns the FIFO sample pointed to by tail
 
+  //Streaming: drain the hardware FIFO straight into the caller's storage
+  //instead of the 4-slot sense buffer. Samples that do not fit stay in the
+  //sensor's FIFO for the next call.
+  uint16_t readSamples(max30102_sample_t *dest, uint16_t maxSamples);
+  template <uint32_t N>
+  uint16_t readSamples(SampleRing<max30102_sample_t, N> &ring)
+  {
+    return (drainFIFO(N - ring.available(), pushToRing<N>, &ring));
+  }
+  uint32_t getOverflowCount(void) { return (fifoOverflows); } //Samples the sensor dropped, from OVF_COUNTER
+  void resetOverflowCount(void) { fifoOverflows = 0; }
+
   uint8_t getWritePointer(void);
   uint8_t getReadPointer(void);
   void clearFIFO(void); //Sets the read/write pointers to zero
@@ -117,8 +180,47 @@ class MAX30102 {
 	void caldata(double *avered,double *aveir,double *sumirrms,double *sumredrms,int32_t red, int32_t ir);
   bool get_avgBPM(int32_t *irValue,int *beatAvg, float *beatsPerMinute);
   void get_ESPO2(int32_t ir, double *avered,double *aveir,double *sumirrms,double *sumredrms, double *SpO2, double *ESpO2);
+  //Integer only equivalent of caldata() + get_ESPO2()
+  static void initSpO2(max30102_spo2_t *state, int16_t ESpO2 = 950);
+  static bool calSpO2(max30102_spo2_t *state, int32_t red, int32_t ir);
  private:
-  TwoWire *_i2cPort; //The generic connection to user's chosen I2C hardware
+  I2CDevice _i2c; //Shared bus of the user's chosen I2C port, at the requested speed
+
+  I2CTransfer checkXfer;
+  uint8_t checkPointers[3];
+  I2CTransfer checkDataXfer; //Follow-up FIFO_DATA read queued by onCheckPointers()
+  uint8_t checkData[MAX30102_FIFO_DEPTH * 9];
+  volatile bool checkRunning;
+  volatile uint16_t checkSamples;
+
+  volatile uint32_t fifoOverflows;
+
+  static void onAlmostFull(void *arg);
+  static void streamLoop(void *arg);
+  volatile bool streaming;
+  uint8_t streamPin;
+  TaskHandle_t streamTask;
+  TaskHandle_t streamConsumer;
+  SampleRing<max30102_sample_t, MAX30102_STREAM_DEPTH> ring;
+
+  //get_avgBPM() state, per sensor
+  BeatDetector<> beat;
+  byte rateSpot;
+  byte rates[MAX30102_RATE_SIZE]; //Array of heart rates
+  long lastBeat; //Time at which the last beat occurred
+  uint16_t espo2Count; //get_ESPO2() samples in the current window
+
+  uint16_t readFIFO(byte readPointer, byte writePointer);
+  typedef void (*SampleSink)(void *ctx, const max30102_sample_t &sample);
+  uint16_t drainFIFO(uint16_t maxSamples, SampleSink sink, void *ctx, bool *complete = NULL);
+  static void storeToArray(void *ctx, const max30102_sample_t &sample);
+  template <uint32_t N>
+  static void pushToRing(void *ctx, const max30102_sample_t &sample)
+  {
+    ((SampleRing<max30102_sample_t, N> *)ctx)->push(sample);
+  }
+  static void onCheckPointers(I2CTransfer *xfer, void *arg);
+  static void onCheckData(I2CTransfer *xfer, void *arg);
   uint8_t _i2caddr;
 
   //activeLEDs is the number of channels turned on, and can be 1 to 3. 2 is common for Red+IR.
@@ -1,21 +1,48 @@
 #include "MPU6886.h"
 
+/**
+  * @brief  Unpack one big-endian accel/temp/gyro frame
+  * @param  buf：14 bytes in register order
+  * @param  raw：Pointer to the unscaled sample
+  * @retval none
+  */
+static void unpackRaw(const uint8_t* buf, mpu6886_raw_t* raw) {
+  raw->ax = (int16_t)((buf[0] << 8) | buf[1]);
+  raw->ay = (int16_t)((buf[2] << 8) | buf[3]);
+  raw->az = (int16_t)((buf[4] << 8) | buf[5]);
+  raw->temp = (int16_t)((buf[6] << 8) | buf[7]);
+  raw->gx = (int16_t)((buf[8] << 8) | buf[9]);
+  raw->gy = (int16_t)((buf[10] << 8) | buf[11]);
+  raw->gz = (int16_t)((buf[12] << 8) | buf[13]);
+}
+
 /**
   * @brief  Read a byte of data
   * @param  address：Register address
   * @retval data value
   */
 uint8_t I2C_MPU6886::readByte(uint8_t address) {
-  Wire.beginTransmission(ADDR);
-  Wire.write(address);
-  Wire.endTransmission();
-  Wire.requestFrom(ADDR, 1);
-  uint8_t val = Wire.read();
+  uint8_t val = 0;
+  i2c.readReg(address, &val);
 
   ESP_LOGD("MPU6886", "readByte(%02X) = %02X", address, val);
   return val;
 }
 
+/**
+  * @brief  Read consecutive registers in one transaction
+  * @param  address：First register address
+  * @param  count：Number of bytes to read
+  * @param  dest：Buffer receiving the data
+  * @retval Number of bytes actually read
+  */
+uint8_t I2C_MPU6886::readBytes(uint8_t address, uint8_t count, uint8_t* dest) {
+  uint8_t got = i2c.readRegs(address, dest, count);
+
+  ESP_LOGD("MPU6886", "readBytes(%02X, %d) = %d", address, count, got);
+  return got;
+}
+
 /**
   * @brief  Write a byte of data
   * @param  address：Register address
@@ -23,19 +50,16 @@ uint8_t I2C_MPU6886::readByte(uint8_t address) {
   * @retval none
   */
 void I2C_MPU6886::writeByte(uint8_t address, uint8_t data) {
-  Wire.beginTransmission(ADDR);
-  Wire.write(address);
-  Wire.write(data);
-  Wire.endTransmission();
+  i2c.writeReg(address, data);
   ESP_LOGD("MPU6886", "writeByte(%02X) = %02X", address, data);
 }
 
 /**
   * @brief  Initialize mpu6886
-  * @param  void
+  * @param  cfg：Full-scale ranges, sample rate divider and filter bandwidths
   * @retval success:return 0; failed:return 1
   */
-int I2C_MPU6886::begin(void) {
+int I2C_MPU6886::begin(const mpu6886Config_t& cfg) {
   // WHO_AM_I : IMU Check
   uint8_t temp;
   temp=readByte(MPU6886_WHOAMI);
@@ -56,30 +80,13 @@ int I2C_MPU6886::begin(void) {
   writeByte(MPU6886_PWR_MGMT_1, 1 << 0);
   delay(10);
 
-  // ACCEL_CONFIG(0x1c) : +-8G
-  writeByte(MPU6886_ACCEL_CONFIG, 0x10);
-  delay(1);
-
-  // GYRO_CONFIG(0x1b) : +-2000dps
-  writeByte(MPU6886_GYRO_CONFIG, 0x18);
-  delay(1);
-
-  // CONFIG(0x1a)
-  writeByte(MPU6886_CONFIG, 0x01);
-  delay(1);
-
-  // SMPLRT_DIV(0x19)
-  writeByte(MPU6886_SMPLRT_DIV, 0x05);
-  delay(1);
+  // ACCEL_CONFIG(0x1c), GYRO_CONFIG(0x1b), CONFIG(0x1a), SMPLRT_DIV(0x19), ACCEL_CONFIG 2(0x1d)
+  configure(cfg);
 
   // INT_ENABLE(0x38)
   writeByte(MPU6886_INT_ENABLE, 0x00);
   delay(1);
 
-  // ACCEL_CONFIG 2(0x1d)
-  writeByte(MPU6886_ACCEL_CONFIG2, 0x00);
-  delay(1);
-
   // USER_CTRL(0x6a)
   writeByte(MPU6886_USER_CTRL, 0x00);
   delay(1);
@@ -99,6 +106,97 @@ int I2C_MPU6886::begin(void) {
   return 0;
 }
 
+/**
+  * @brief  Apply a complete configuration
+  * @param  cfg：Full-scale ranges, sample rate divider and filter bandwidths
+  * @retval none
+  */
+void I2C_MPU6886::configure(const mpu6886Config_t& cfg) {
+  setAccelScale(cfg.accelScale);
+  setGyroScale(cfg.gyroScale);
+  setGyroDLPF(cfg.gyroDlpf);
+  setSampleRateDivider(cfg.sampleRateDiv);
+  setAccelDLPF(cfg.accelDlpf);
+}
+
+/**
+  * @brief  Set the accelerometer full-scale range and cache its LSB weight
+  * @param  scale：MPU6886_AFS_2G..MPU6886_AFS_16G
+  * @retval none
+  */
+void I2C_MPU6886::setAccelScale(mpu6886Ascale_t scale) {
+  // ACCEL_CONFIG(0x1c)
+  writeByte(MPU6886_ACCEL_CONFIG, scale << 3);
+  delay(1);
+
+  config.accelScale = scale;
+  aRes = mpu6886AccelRes(scale);
+}
+
+/**
+  * @brief  Set the gyroscope full-scale range and cache its LSB weight
+  * @param  scale：MPU6886_GFS_250DPS..MPU6886_GFS_2000DPS
+  * @retval none
+  */
+void I2C_MPU6886::setGyroScale(mpu6886Gscale_t scale) {
+  // GYRO_CONFIG(0x1b)
+  writeByte(MPU6886_GYRO_CONFIG, scale << 3);
+  delay(1);
+
+  config.gyroScale = scale;
+  gRes = mpu6886GyroRes(scale);
+}
+
+/**
+  * @brief  Set the sample rate divider, ODR = 1kHz / (1 + div)
+  * @param  div：divider value
+  * @retval none
+  */
+void I2C_MPU6886::setSampleRateDivider(uint8_t div) {
+  // SMPLRT_DIV(0x19)
+  writeByte(MPU6886_SMPLRT_DIV, div);
+  delay(1);
+
+  config.sampleRateDiv = div;
+}
+
+/**
+  * @brief  Set the gyroscope and temperature low pass filter
+  * @param  dlpf：filter bandwidth
+  * @retval none
+  */
+void I2C_MPU6886::setGyroDLPF(mpu6886Dlpf_t dlpf) {
+  // CONFIG(0x1a) : keep FIFO_MODE
+  writeByte(MPU6886_CONFIG, (readByte(MPU6886_CONFIG) & MPU6886_CONFIG_FIFO_MODE) | dlpf);
+  delay(1);
+
+  config.gyroDlpf = dlpf;
+}
+
+/**
+  * @brief  Set the accelerometer low pass filter
+  * @param  dlpf：filter bandwidth
+  * @retval none
+  */
+void I2C_MPU6886::setAccelDLPF(mpu6886AccelDlpf_t dlpf) {
+  // ACCEL_CONFIG 2(0x1d)
+  writeByte(MPU6886_ACCEL_CONFIG2, dlpf);
+  delay(1);
+
+  config.accelDlpf = dlpf;
+}
+
+/**
+  * @brief  Get the time between two samples for the current configuration
+  * @param  void
+  * @retval sample period in microseconds
+  */
+uint32_t I2C_MPU6886::getSamplePeriodUs(void) {
+  if (config.gyroDlpf == MPU6886_DLPF_250HZ || config.gyroDlpf == MPU6886_DLPF_3281HZ)
+    return 125;
+  return 1000UL * (1 + config.sampleRateDiv);
+}
+
 /**
   * @brief  Obtain the acceleration data of x-axis, Y-axis and z-axis 
   * @param  *ax:Acceleration data pointer to X-axis
@@ -107,10 +205,12 @@ int I2C_MPU6886::begin(void) {
   * @retval none
   */
 void I2C_MPU6886::getAccel(float* ax, float* ay, float* az) {
-  float aRes = 8.0 / 32768.0;
-  *ax = (int16_t)((readByte(MPU6886_ACCEL_XOUT_H) << 8) | readByte(MPU6886_ACCEL_XOUT_L)) * aRes;
-  *ay = (int16_t)((readByte(MPU6886_ACCEL_YOUT_H) << 8) | readByte(MPU6886_ACCEL_YOUT_L)) * aRes;
-  *az = (int16_t)((readByte(MPU6886_ACCEL_ZOUT_H) << 8) | readByte(MPU6886_ACCEL_ZOUT_L)) * aRes;
+  uint8_t buf[6];
+  I2C_STATS_SITE(i2c.getBus(), "MPU6886::getAccel");
+  readBytes(MPU6886_ACCEL_XOUT_H, 6, buf);
+  *ax = (int16_t)((buf[0] << 8) | buf[1]) * aRes;
+  *ay = (int16_t)((buf[2] << 8) | buf[3]) * aRes;
+  *az = (int16_t)((buf[4] << 8) | buf[5]) * aRes;
 }
 
 /**
@@ -121,10 +221,42 @@ void I2C_MPU6886::getAccel(float* ax, float* ay, float* az) {
   * @retval none
   */
 void I2C_MPU6886::getGyro(float* gx, float* gy, float* gz) {
-  float gRes = 2000.0 / 32768.0;
-  *gx = (int16_t)((readByte(MPU6886_GYRO_XOUT_H) << 8) | readByte(MPU6886_GYRO_XOUT_L)) * gRes;
-  *gy = (int16_t)((readByte(MPU6886_GYRO_YOUT_H) << 8) | readByte(MPU6886_GYRO_YOUT_L)) * gRes;
-  *gz = (int16_t)((readByte(MPU6886_GYRO_ZOUT_H) << 8) | readByte(MPU6886_GYRO_ZOUT_L)) * gRes;
+  uint8_t buf[6];
+  I2C_STATS_SITE(i2c.getBus(), "MPU6886::getGyro");
+  readBytes(MPU6886_GYRO_XOUT_H, 6, buf);
+  *gx = (int16_t)((buf[0] << 8) | buf[1]) * gRes;
+  *gy = (int16_t)((buf[2] << 8) | buf[3]) * gRes;
+  *gz = (int16_t)((buf[4] << 8) | buf[5]) * gRes;
+}
+
+/**
+  * @brief  Obtain the unscaled acceleration data, see getAccelQScale()
+  * @param  *ax:Raw data pointer to X-axis
+  * @param  *ay:Raw data pointer to y-axis
+  * @param  *az:Raw data pointer to z-axis
+  * @retval none
+  */
+void I2C_MPU6886::getAccelRaw(int16_t* ax, int16_t* ay, int16_t* az) {
+  uint8_t buf[6];
+  readBytes(MPU6886_ACCEL_XOUT_H, 6, buf);
+  *ax = (int16_t)((buf[0] << 8) | buf[1]);
+  *ay = (int16_t)((buf[2] << 8) | buf[3]);
+  *az = (int16_t)((buf[4] << 8) | buf[5]);
+}
+
+/**
+  * @brief  Obtain the unscaled angular velocity data, see getGyroQScale()
+  * @param  *gx:Raw data pointer to X-axis
+  * @param  *gy:Raw data pointer to y-axis
+  * @param  *gz:Raw data pointer to z-axis
+  * @retval none
+  */
+void I2C_MPU6886::getGyroRaw(int16_t* gx, int16_t* gy, int16_t* gz) {
+  uint8_t buf[6];
+  readBytes(MPU6886_GYRO_XOUT_H, 6, buf);
+  *gx = (int16_t)((buf[0] << 8) | buf[1]);
+  *gy = (int16_t)((buf[2] << 8) | buf[3]);
+  *gz = (int16_t)((buf[4] << 8) | buf[5]);
 }
 
 /**
@@ -133,5 +265,320 @@ void I2C_MPU6886::getGyro(float* gx, float* gy, float* gz) {
   * @retval none
   */
 void I2C_MPU6886::getTemp(float *t) {
-  *t = 25.0 + ((readByte(MPU6886_TEMP_OUT_H) << 8) | readByte(MPU6886_TEMP_OUT_L)) / 326.8;
-}
\ No newline at end of file
+  uint8_t buf[2];
+  I2C_STATS_SITE(i2c.getBus(), "MPU6886::getTemp");
+  readBytes(MPU6886_TEMP_OUT_H, 2, buf);
+  *t = 25.0 + (int16_t)((buf[0] << 8) | buf[1]) / 326.8;
+}
+
+/**
+  * @brief  Read accel, temperature and gyro (0x3B..0x48) in a single burst,
+  *         so every axis belongs to the same sample
+  * @param  *raw：Pointer to the unscaled sample
+  * @retval success:return 0; failed:return -1
+  */
+int I2C_MPU6886::readAll(mpu6886_raw_t* raw) {
+  uint8_t buf[MPU6886_MOTION_DATA_LEN];
+  I2C_STATS_SITE(i2c.getBus(), "MPU6886::readAll");
+  if (readBytes(MPU6886_ACCEL_XOUT_H, MPU6886_MOTION_DATA_LEN, buf) != MPU6886_MOTION_DATA_LEN)
+    return -1;
+
+  unpackRaw(buf, raw);
+  return 0;
+}
+
+/**
+  * @brief  Convert a raw sample to g, dps and degrees Celsius
+  * @param  *raw：Pointer to the unscaled sample
+  * @param  *motion：Pointer to the scaled sample
+  * @retval none
+  */
+void I2C_MPU6886::scaleMotion(const mpu6886_raw_t* raw, mpu6886_motion_t* motion) {
+  motion->ax = raw->ax * aRes;
+  motion->ay = raw->ay * aRes;
+  motion->az = raw->az * aRes;
+  motion->gx = raw->gx * gRes;
+  motion->gy = raw->gy * gRes;
+  motion->gz = raw->gz * gRes;
+  motion->t = 25.0f + raw->temp * (1.0f / 326.8f);
+}
+
+/**
+  * @brief  Convert a block of raw samples with the current ranges
+  * @param  *raw：Unscaled samples
+  * @param  *motion：Receives count samples in g, dps and degrees Celsius
+  * @param  count：Number of samples
+  * @retval none
+  */
+void I2C_MPU6886::scaleMotion(const mpu6886_raw_t* raw, mpu6886_motion_t* motion, uint32_t count) {
+  mpu6886ToMotion(raw, motion, count, aRes, gRes);
+}
+
+/**
+  * @brief  Convert a block of raw samples to integer units with the current ranges
+  * @param  *raw：Unscaled samples
+  * @param  *out：Receives count samples in milli-g, milli-dps and centi-degrees Celsius
+  * @param  count：Number of samples
+  * @retval none
+  */
+void I2C_MPU6886::scaleFixed(const mpu6886_raw_t* raw, mpu6886_fixed_t* out, uint32_t count) {
+  mpu6886ToFixed(raw, out, count, getAccelQScale(), getGyroQScale());
+}
+
+/**
+  * @brief  Read and scale accel, temperature and gyro from one sample
+  * @param  *motion：Pointer to the scaled sample
+  * @retval success:return 0; failed:return -1
+  */
+int I2C_MPU6886::getMotion(mpu6886_motion_t* motion) {
+  mpu6886_raw_t raw;
+  if (readAll(&raw))
+    return -1;
+
+  scaleMotion(&raw, motion);
+  return 0;
+}
+
+/**
+  * @brief  Start streaming accel+gyro samples into the hardware FIFO
+  * @param  void
+  * @retval none
+  */
+void I2C_MPU6886::enableFIFO(void) {
+  fifoOverflows = 0;
+
+  // CONFIG(0x1a) : keep the FIFO frame aligned when it fills up
+  writeByte(MPU6886_CONFIG, readByte(MPU6886_CONFIG) | MPU6886_CONFIG_FIFO_MODE);
+  delay(1);
+
+  // FIFO_EN(0x23)
+  writeByte(MPU6886_FIFO_EN, MPU6886_FIFO_GYRO_ACCEL);
+  delay(1);
+
+  // USER_CTRL(0x6a) : enable and reset the FIFO
+  writeByte(MPU6886_USER_CTRL, MPU6886_USER_FIFO_EN | MPU6886_USER_FIFO_RST);
+  delay(1);
+}
+
+/**
+  * @brief  Stop streaming into the hardware FIFO
+  * @param  void
+  * @retval none
+  */
+void I2C_MPU6886::disableFIFO(void) {
+  // FIFO_EN(0x23)
+  writeByte(MPU6886_FIFO_EN, 0x00);
+  delay(1);
+
+  // USER_CTRL(0x6a)
+  writeByte(MPU6886_USER_CTRL, 0x00);
+  delay(1);
+}
+
+/**
+  * @brief  Discard everything in the hardware FIFO
+  * @param  void
+  * @retval none
+  */
+void I2C_MPU6886::resetFIFO(void) {
+  writeByte(MPU6886_USER_CTRL, readByte(MPU6886_USER_CTRL) | MPU6886_USER_FIFO_RST);
+}
+
+/**
+  * @brief  Get the number of bytes waiting in the hardware FIFO
+  * @param  void
+  * @retval FIFO fill level in bytes
+  */
+uint16_t I2C_MPU6886::getFIFOCount(void) {
+  uint8_t buf[2];
+  if (readBytes(MPU6886_FIFO_CONUTH, 2, buf) != 2)
+    return 0;
+  return ((buf[0] & 0x1F) << 8) | buf[1];
+}
+
+/**
+  * @brief  Drain the hardware FIFO in as few I2C reads as Wire allows
+  * @param  *samples：Array receiving the samples, oldest first
+  * @param  maxSamples：Capacity of samples
+  * @retval Number of samples stored
+  */
+uint16_t I2C_MPU6886::readFIFO(mpu6886_sample_t* samples, uint16_t maxSamples) {
+  uint8_t buf[MPU6886_FIFO_CHUNK_LEN];
+  I2C_STATS_SITE(i2c.getBus(), "MPU6886::readFIFO");
+
+  // The FIFO stops accepting frames once full, so an overflow only loses the newest samples
+  if (readByte(MPU6886_INT_STATUS) & MPU6886_INT_FIFO_OFLOW)
+    fifoOverflows++;
+
+  uint16_t pending = getFIFOCount() / MPU6886_FIFO_FRAME_LEN;
+  uint32_t now = micros();
+  uint32_t period = getSamplePeriodUs();
+  uint16_t frames = pending < maxSamples ? pending : maxSamples;
+  uint16_t done = 0;
+
+  while (done < frames) {
+    uint16_t n = frames - done;
+    if (n > MPU6886_FIFO_CHUNK_LEN / MPU6886_FIFO_FRAME_LEN)
+      n = MPU6886_FIFO_CHUNK_LEN / MPU6886_FIFO_FRAME_LEN;
+
+    if (readBytes(MPU6886_FIFO_R_W, n * MPU6886_FIFO_FRAME_LEN, buf) != n * MPU6886_FIFO_FRAME_LEN)
+      break;
+
+    for (uint16_t i = 0; i < n; i++, done++) {
+      unpackRaw(&buf[i * MPU6886_FIFO_FRAME_LEN], &samples[done].raw);
+      // The newest frame in the FIFO was taken at most one period ago, older ones one period apart
+      samples[done].timestamp = now - (uint32_t)(pending - 1 - done) * period;
+    }
+  }
+
+  return done;
+}
+
+/**
+  * @brief  Data-ready interrupt: stamp the sample and wake the reader task
+  * @param  arg：The I2C_MPU6886 instance
+  * @retval none
+  */
+void IRAM_ATTR I2C_MPU6886::onDataReady(void* arg) {
+  I2C_MPU6886* imu = static_cast<I2C_MPU6886*>(arg);
+  BaseType_t woken = pdFALSE;
+
+  imu->irqTimestamp = micros();
+  vTaskNotifyGiveFromISR(imu->streamTask, &woken);
+  if (woken == pdTRUE)
+    portYIELD_FROM_ISR();
+}
+
+/**
+  * @brief  Reader task: one burst read per data-ready interrupt into the sample ring
+  * @param  arg：The I2C_MPU6886 instance
+  * @retval none
+  */
+void I2C_MPU6886::streamLoop(void* arg) {
+  I2C_MPU6886* imu = static_cast<I2C_MPU6886*>(arg);
+  // INT_STATUS(0x3a) sits right before ACCEL_XOUT_H, so one read also acknowledges the interrupt
+  uint8_t buf[1 + MPU6886_MOTION_DATA_LEN];
+  mpu6886_sample_t sample;
+
+  while (1) {
+    uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (!imu->streaming)
+      break;
+
+    // Only the newest sample is still in the data registers
+    if (pending > 1)
+      imu->streamMissed += pending - 1;
+
+    sample.timestamp = imu->irqTimestamp;
+    if (imu->readBytes(MPU6886_INT_STATUS, sizeof(buf), buf) != sizeof(buf))
+      continue;
+    unpackRaw(&buf[1], &sample.raw);
+
+    imu->ring.push(sample);
+    if (imu->streamConsumer != NULL)
+      xTaskNotifyGive(imu->streamConsumer);
+  }
+
+  imu->streamTask = NULL;
+  vTaskDelete(NULL);
+}
+
+/**
+  * @brief  Start the interrupt driven pipeline: data-ready -> reader task -> sample ring
+  * @param  intPin：GPIO connected to the MPU6886 INT pin
+  * @param  priority：Priority of the reader task
+  * @param  core：Core the reader task is pinned to
+  * @retval success:return 0; failed:return -1
+  */
+int I2C_MPU6886::startStream(uint8_t intPin, UBaseType_t priority, BaseType_t core) {
+  if (streaming)
+    return -1;
+
+  ring.clear();
+  streamMissed = 0;
+  streamPin = intPin;
+  streaming = true;
+
+  if (xTaskCreatePinnedToCore(streamLoop, "mpu6886", 2048, this, priority, &streamTask, core) != pdPASS) {
+    streaming = false;
+    streamTask = NULL;
+    return -1;
+  }
+
+  // INT_PIN_CFG(0x37) : 50us pulse per sample rather than a latched level, a failed read can not stall the stream
+  writeByte(MPU6886_INT_PIN_CFG, readByte(MPU6886_INT_PIN_CFG) & ~MPU6886_INT_LATCH_EN);
+  readByte(MPU6886_INT_STATUS);
+
+  pinMode(streamPin, INPUT);
+  attachInterruptArg(streamPin, onDataReady, this, RISING);
+  return 0;
+}
+
+/**
+  * @brief  Stop the interrupt driven pipeline and wait for the reader task to exit
+  * @param  void
+  * @retval none
+  */
+void I2C_MPU6886::stopStream(void) {
+  if (!streaming)
+    return;
+
+  detachInterrupt(streamPin);
+  streaming = false;
+  xTaskNotifyGive(streamTask);
+  while (streamTask != NULL)
+    delay(1);
+
+  // INT_PIN_CFG(0x37)
+  writeByte(MPU6886_INT_PIN_CFG, readByte(MPU6886_INT_PIN_CFG) | MPU6886_INT_LATCH_EN);
+}
+
+/**
+  * @brief  Convert a block of raw samples to milli-g, milli-dps and centi-degrees Celsius.
+  *         Only integer multiply and shift, no branches, so the compiler is free to
+  *         unroll or vectorize the loop on targets that support it.
+  * @param  *raw：Unscaled samples
+  * @param  *out：Converted samples
+  * @param  count：Number of samples
+  * @param  accel：Accelerometer scale, see mpu6886AccelQScale()
+  * @param  gyro：Gyroscope scale, see mpu6886GyroQScale()
+  * @retval none
+  */
+void mpu6886ToFixed(const mpu6886_raw_t* raw, mpu6886_fixed_t* out, uint32_t count,
+                    mpu6886_qscale_t accel, mpu6886_qscale_t gyro) {
+  const int32_t am = accel.mul, gm = gyro.mul;
+  const uint8_t as = accel.shift, gs = gyro.shift;
+
+  for (uint32_t i = 0; i < count; i++) {
+    out[i].ax = (int16_t)((raw[i].ax * am) >> as);
+    out[i].ay = (int16_t)((raw[i].ay * am) >> as);
+    out[i].az = (int16_t)((raw[i].az * am) >> as);
+    // 25C + raw / 326.8, 100 / 326.8 ~= 20054 / 2^16
+    out[i].temp = (int16_t)(2500 + ((raw[i].temp * 20054) >> 16));
+    out[i].gx = (raw[i].gx * gm) >> gs;
+    out[i].gy = (raw[i].gy * gm) >> gs;
+    out[i].gz = (raw[i].gz * gm) >> gs;
+  }
+}
+
+/**
+  * @brief  Convert a block of raw samples to g, dps and degrees Celsius in one pass
+  * @param  *raw：Unscaled samples
+  * @param  *out：Converted samples
+  * @param  count：Number of samples
+  * @param  ares：g per LSB, see mpu6886AccelRes()
+  * @param  gres：dps per LSB, see mpu6886GyroRes()
+  * @retval none
+  */
+void mpu6886ToMotion(const mpu6886_raw_t* raw, mpu6886_motion_t* out, uint32_t count,
+                     float ares, float gres) {
+  for (uint32_t i = 0; i < count; i++) {
+    out[i].ax = raw[i].ax * ares;
+    out[i].ay = raw[i].ay * ares;
+    out[i].az = raw[i].az * ares;
+    out[i].gx = raw[i].gx * gres;
+    out[i].gy = raw[i].gy * gres;
+    out[i].gz = raw[i].gz * gres;
+    out[i].t = 25.0f + raw[i].temp * (1.0f / 326.8f);
+  }
+}
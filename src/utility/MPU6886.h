@@ -1,13 +1,17 @@
 #ifndef MPU6886_H__
 #define MPU6886_H__
 
+#include <Arduino.h>
 #include <Wire.h>
+#include "I2CBus.h"
+#include "SampleRing.h"
 
 #define MPU6886_WHOAMI            0x75
 #define MPU6886_ACCEL_INTEL_CTRL  0x69
 #define MPU6886_SMPLRT_DIV        0x19          
 #define MPU6886_INT_PIN_CFG       0x37
 #define MPU6886_INT_ENABLE        0x38
+#define MPU6886_INT_STATUS        0x3A
 #define MPU6886_ACCEL_XOUT_H      0x3B          
 #define MPU6886_ACCEL_XOUT_L      0x3C          
 #define MPU6886_ACCEL_YOUT_H      0x3D          
@@ -39,24 +43,226 @@
 #define MPU6886_FIFO_CONUTL       0x73          
 #define MPU6886_FIFO_R_W          0x74          
 
+#define MPU6886_FIFO_GYRO_ACCEL   0x18          //FIFO_EN: gyro + accel (temperature is always included)
+#define MPU6886_USER_FIFO_EN      0x40          //USER_CTRL: enable FIFO
+#define MPU6886_USER_FIFO_RST     0x04          //USER_CTRL: reset FIFO
+#define MPU6886_CONFIG_FIFO_MODE  0x40          //CONFIG: stop writing when full instead of overwriting
+#define MPU6886_INT_FIFO_OFLOW    0x10          //INT_STATUS: FIFO overflow
+#define MPU6886_INT_LATCH_EN      0x20          //INT_PIN_CFG: hold INT until INT_STATUS is read
+
+
+#define MPU6886_MOTION_DATA_LEN   14            //ACCEL_XOUT_H..GYRO_ZOUT_L in one burst
+
+#define MPU6886_FIFO_FRAME_LEN    14            //One accel+temp+gyro packet in the FIFO
+
+//Wire can not return more than its buffer per requestFrom(), read the FIFO in whole frames that fit
+#ifdef I2C_BUFFER_LENGTH
+#define MPU6886_FIFO_CHUNK_LEN    (I2C_BUFFER_LENGTH - (I2C_BUFFER_LENGTH % MPU6886_FIFO_FRAME_LEN))
+#else
+#define MPU6886_FIFO_CHUNK_LEN    (32 - (32 % MPU6886_FIFO_FRAME_LEN))
+#endif
+
+#define MPU6886_STREAM_DEPTH      64            //Samples buffered between the data-ready reader task and the consumer
 
 #define ADDR 0x68                               //IIC correspondence address of MPU6886
 
+// ACCEL_CONFIG full-scale range
+typedef enum {
+  MPU6886_AFS_2G = 0,
+  MPU6886_AFS_4G,
+  MPU6886_AFS_8G,
+  MPU6886_AFS_16G
+} mpu6886Ascale_t;
+
+// GYRO_CONFIG full-scale range
+typedef enum {
+  MPU6886_GFS_250DPS = 0,
+  MPU6886_GFS_500DPS,
+  MPU6886_GFS_1000DPS,
+  MPU6886_GFS_2000DPS
+} mpu6886Gscale_t;
+
+// CONFIG DLPF_CFG: gyro and temperature bandwidth. SMPLRT_DIV only applies to 176Hz..5Hz,
+// the other two settings sample at 8kHz.
+typedef enum {
+  MPU6886_DLPF_250HZ = 0,
+  MPU6886_DLPF_176HZ,
+  MPU6886_DLPF_92HZ,
+  MPU6886_DLPF_41HZ,
+  MPU6886_DLPF_20HZ,
+  MPU6886_DLPF_10HZ,
+  MPU6886_DLPF_5HZ,
+  MPU6886_DLPF_3281HZ
+} mpu6886Dlpf_t;
+
+// ACCEL_CONFIG2 A_DLPF_CFG: accelerometer bandwidth
+typedef enum {
+  MPU6886_ADLPF_218HZ = 0,
+  MPU6886_ADLPF_99HZ = 2,
+  MPU6886_ADLPF_45HZ,
+  MPU6886_ADLPF_21HZ,
+  MPU6886_ADLPF_10HZ,
+  MPU6886_ADLPF_5HZ,
+  MPU6886_ADLPF_420HZ
+} mpu6886AccelDlpf_t;
+
+typedef struct {
+  mpu6886Ascale_t accelScale;
+  mpu6886Gscale_t gyroScale;
+  uint8_t sampleRateDiv;              // ODR = 1kHz / (1 + sampleRateDiv)
+  mpu6886Dlpf_t gyroDlpf;
+  mpu6886AccelDlpf_t accelDlpf;
+} mpu6886Config_t;
+
+// +-8g, +-2000dps, 166Hz ODR, 176Hz gyro / 218Hz accel bandwidth
+static const mpu6886Config_t MPU6886_DEFAULT_CONFIG = {
+  MPU6886_AFS_8G, MPU6886_GFS_2000DPS, 5, MPU6886_DLPF_176HZ, MPU6886_ADLPF_218HZ
+};
+
+// Weight of one LSB in g / dps for a full-scale range, folds to a constant for a fixed range
+constexpr float mpu6886AccelRes(mpu6886Ascale_t scale) { return (2.0f * (1 << scale)) / 32768.0f; }
+constexpr float mpu6886GyroRes(mpu6886Gscale_t scale) { return (250.0f * (1 << scale)) / 32768.0f; }
+
+// One accel/temp/gyro sample, in the order the registers are laid out (0x3B..0x48)
+typedef struct __attribute__ ((packed)) {
+  int16_t ax, ay, az;
+  int16_t temp;
+  int16_t gx, gy, gz;
+} mpu6886_raw_t;
+
+// A raw sample scaled to g, dps and degrees Celsius
+typedef struct {
+  float ax, ay, az;
+  float gx, gy, gz;
+  float t;
+} mpu6886_motion_t;
+
+// A raw sample in integer units: milli-g, milli-dps and centi-degrees Celsius
+typedef struct {
+  int16_t ax, ay, az;
+  int16_t temp;
+  int32_t gx, gy, gz;
+} mpu6886_fixed_t;
+
+// Integer scale factor: physical = (raw * mul) >> shift
+typedef struct {
+  int32_t mul;
+  uint8_t shift;
+} mpu6886_qscale_t;
+
+// milli-g per LSB = 2000 * 2^scale / 2^15
+constexpr mpu6886_qscale_t mpu6886AccelQScale(mpu6886Ascale_t scale) {
+  return mpu6886_qscale_t{ 2000, (uint8_t)(15 - scale) };
+}
+// milli-dps per LSB = 250000 * 2^scale / 2^15 = 31250 * 2^scale / 2^12
+constexpr mpu6886_qscale_t mpu6886GyroQScale(mpu6886Gscale_t scale) {
+  return mpu6886_qscale_t{ 31250, (uint8_t)(12 - scale) };
+}
+
+void mpu6886ToFixed(const mpu6886_raw_t* raw, mpu6886_fixed_t* out, uint32_t count,
+                    mpu6886_qscale_t accel, mpu6886_qscale_t gyro);
+void mpu6886ToMotion(const mpu6886_raw_t* raw, mpu6886_motion_t* out, uint32_t count,
+                     float ares, float gres);
+
+// A raw sample together with the micros() time at which it was taken
+typedef struct {
+  uint32_t timestamp;
+  mpu6886_raw_t raw;
+} mpu6886_sample_t;
+
 class I2C_MPU6886 {
   public:
-    I2C_MPU6886(){}
+    I2C_MPU6886() : i2c(ADDR), config(MPU6886_DEFAULT_CONFIG),
+                    aRes(mpu6886AccelRes(MPU6886_DEFAULT_CONFIG.accelScale)),
+                    gRes(mpu6886GyroRes(MPU6886_DEFAULT_CONFIG.gyroScale)), fifoOverflows(0),
+                    streaming(false), streamPin(0), streamTask(NULL), streamConsumer(NULL),
+                    irqTimestamp(0), streamMissed(0) {}
+
+    int begin(const mpu6886Config_t& cfg = MPU6886_DEFAULT_CONFIG);
+
+    /**
+      * @brief  Move the IMU to another bus or SCL frequency, call before begin()
+      * @param  bus：Shared bus the IMU sits on
+      * @param  clock：SCL frequency in Hz, 0 for the bus default
+      */
+    void setBus(I2CBus& bus, uint32_t clock = 0) { i2c.setBus(bus); i2c.setClock(clock); }
 
-    int begin(void);
+    void configure(const mpu6886Config_t& cfg);
+    void setAccelScale(mpu6886Ascale_t scale);
+    void setGyroScale(mpu6886Gscale_t scale);
+    void setSampleRateDivider(uint8_t div);
+    void setGyroDLPF(mpu6886Dlpf_t dlpf);
+    void setAccelDLPF(mpu6886AccelDlpf_t dlpf);
+    const mpu6886Config_t& getConfig(void) { return config; }
+    uint32_t getSamplePeriodUs(void);
 
     void getAccel(float* ax, float* ay, float* az);
     void getGyro(float* gx, float* gy, float* gz);
     void getTemp(float *t);
 
+    void getAccelRaw(int16_t* ax, int16_t* ay, int16_t* az);
+    void getGyroRaw(int16_t* gx, int16_t* gy, int16_t* gz);
+    mpu6886_qscale_t getAccelQScale(void) { return mpu6886AccelQScale(config.accelScale); }
+    mpu6886_qscale_t getGyroQScale(void) { return mpu6886GyroQScale(config.gyroScale); }
+
+    int readAll(mpu6886_raw_t* raw);
+    int getMotion(mpu6886_motion_t* motion);
+    void scaleMotion(const mpu6886_raw_t* raw, mpu6886_motion_t* motion);
+    void scaleMotion(const mpu6886_raw_t* raw, mpu6886_motion_t* motion, uint32_t count);
+    void scaleFixed(const mpu6886_raw_t* raw, mpu6886_fixed_t* out, uint32_t count);
+
+    void enableFIFO(void);
+    void disableFIFO(void);
+    void resetFIFO(void);
+    uint16_t getFIFOCount(void);
+    uint16_t readFIFO(mpu6886_sample_t* samples, uint16_t maxSamples);
+    uint32_t getFIFOOverflows(void) { return fifoOverflows; }
+
+    int startStream(uint8_t intPin, UBaseType_t priority = 10, BaseType_t core = tskNO_AFFINITY);
+    void stopStream(void);
+    void setStreamConsumer(TaskHandle_t task) { streamConsumer = task; }
+    bool readSample(mpu6886_sample_t* sample) { return ring.pop(sample); }
+    uint32_t availableSamples(void) { return ring.available(); }
+    uint32_t getStreamOverruns(void) { return ring.getOverruns(); }
+    uint32_t getStreamMissed(void) { return streamMissed; }
+
   private:
     uint8_t readByte(uint8_t address);
+    uint8_t readBytes(uint8_t address, uint8_t count, uint8_t* dest);
     void writeByte(uint8_t address, uint8_t data);
 
+    I2CDevice i2c;
+    mpu6886Config_t config;
     float aRes, gRes; 
+    uint32_t fifoOverflows;
+
+    static void onDataReady(void* arg);
+    static void streamLoop(void* arg);
+
+    volatile bool streaming;
+    uint8_t streamPin;
+    TaskHandle_t streamTask;
+    TaskHandle_t streamConsumer;
+    volatile uint32_t irqTimestamp;
+    uint32_t streamMissed;
+    SampleRing<mpu6886_sample_t, MPU6886_STREAM_DEPTH> ring;
 };
 
+/**
+  * @brief  Scale a raw sample for a range fixed at compile time, e.g.
+  *         mpu6886ScaleMotion<MPU6886_AFS_8G, MPU6886_GFS_2000DPS>(&raw, &motion)
+  */
+template <mpu6886Ascale_t A, mpu6886Gscale_t G>
+inline void mpu6886ScaleMotion(const mpu6886_raw_t* raw, mpu6886_motion_t* motion) {
+  constexpr float ares = mpu6886AccelRes(A);
+  constexpr float gres = mpu6886GyroRes(G);
+  motion->ax = raw->ax * ares;
+  motion->ay = raw->ay * ares;
+  motion->az = raw->az * ares;
+  motion->gx = raw->gx * gres;
+  motion->gy = raw->gy * gres;
+  motion->gz = raw->gz * gres;
+  motion->t = 25.0f + raw->temp * (1.0f / 326.8f);
+}
+
 #endif
\ No newline at end of file
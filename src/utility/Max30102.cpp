@@ -144,10 +144,11 @@ static const uint8_t MAX_30105_EXPECTEDPARTID = 0x15;
   */
 boolean MAX30102::begin(TwoWire &wirePort, uint32_t i2cSpeed, uint8_t i2caddr) {
 
-  _i2cPort = &wirePort; //Grab which port the user wants us to use
+  _i2c.setBus(I2CBus::get(wirePort)); //Grab which port the user wants us to use
+  _i2c.setAddress(i2caddr);
+  _i2c.setClock(i2cSpeed); //Only applied to our own transactions, other devices keep theirs
 
-  _i2cPort->begin();
-  _i2cPort->setClock(i2cSpeed);
+  _i2c.getBus().begin();
 
   _i2caddr = i2caddr;
 
@@ -373,6 +374,33 @@ void MAX30102::setFIFOAlmostFull(uint8_t numberOfSamples) {
   //Note it is reverse: 0x00 is 32 samples, 0x0F is 17 samples
 }
 
+/**
+  * @brief  读取中断状态1，读取后清除中断标志
+  * @parameter void
+  * @retval 中断状态
+  */
+uint8_t MAX30102::getINT1(void) {
+  return (readRegister8(_i2caddr, MAX30105_INTSTAT1));
+}
+
+/**
+  * @brief  启用FIFO将满中断
+  * @parameter void
+  * @retval void
+  */
+void MAX30102::enableAFULL(void) {
+  bitMask(MAX30105_INTENABLE1, MAX30105_INT_A_FULL_MASK, MAX30105_INT_A_FULL_ENABLE);
+}
+
+/**
+  * @brief  禁用FIFO将满中断
+  * @parameter void
+  * @retval void
+  */
+void MAX30102::disableAFULL(void) {
+  bitMask(MAX30105_INTENABLE1, MAX30105_INT_A_FULL_MASK, MAX30105_INT_A_FULL_DISABLE);
+}
+
 /**
   * @brief  读取FIFO写入指针
   * @parameter void
@@ -662,13 +690,322 @@ void MAX30102::nextSample(void)
   * @retval numberOfSamples: 返回获得的新样本数 
   */
 uint16_t MAX30102::check(void)
+{
+  //FIFO_WR_PTR, OVF_COUNTER and FIFO_RD_PTR are adjacent, fetch them in one go
+  I2C_STATS_SITE(_i2c.getBus(), "MAX30102::check");
+  uint8_t pointers[3];
+
+  if (_i2c.readRegs(MAX30105_FIFOWRITEPTR, pointers, 3) != 3)
+    return (0);
+
+  uint16_t numberOfSamples = readFIFO(pointers[2], pointers[0]);
+  //OVF_COUNTER is only cleared once FIFO data has been read
+  if (numberOfSamples > 0)
+    fifoOverflows += pointers[1];
+  return (numberOfSamples);
+}
+
+/**
+  * @brief  读出FIFO中的新样本到调用者的数组，每次I2C读取尽可能多的完整样本
+  * @parameter dest: 样本数组
+  * @parameter maxSamples: 数组容量，放不下的样本留在传感器FIFO中
+  * @retval 读出的样本数
+  */
+uint16_t MAX30102::readSamples(max30102_sample_t *dest, uint16_t maxSamples)
+{
+  return (drainFIFO(maxSamples, storeToArray, &dest));
+}
+
+void MAX30102::storeToArray(void *ctx, const max30102_sample_t &sample)
+{
+  max30102_sample_t **cursor = (max30102_sample_t **)ctx;
+
+  *(*cursor)++ = sample;
+}
+
+static inline uint32_t fifoChannel(const uint8_t *p)
+{
+  return ((((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]) & 0x3FFFF); //18 bits
+}
+
+/**
+  * @brief  读FIFO指针和溢出计数，然后按整样本分块读出至多maxSamples个样本交给sink
+  *         FIFO写满时写指针等于读指针，要等到溢出计数不为0才能区分于空
+  * @parameter maxSamples: 最多读出的样本数
+  * @parameter sink: 每个样本调用一次
+  * @parameter complete: 可为NULL，FIFO中的样本全部读出时置true，读取失败或有样本留下时置false
+  * @retval 读出的样本数
+  */
+uint16_t MAX30102::drainFIFO(uint16_t maxSamples, SampleSink sink, void *ctx, bool *complete)
+{
+  I2C_STATS_SITE(_i2c.getBus(), "MAX30102::readSamples");
+  uint8_t pointers[3];
+  uint8_t buf[I2C_BUFFER_LENGTH];
+  uint8_t bytesPerSample = activeLEDs * 3;
+
+  if (complete != NULL)
+    *complete = false;
+  if (bytesPerSample == 0 || maxSamples == 0)
+    return (0);
+  if (_i2c.readRegs(MAX30105_FIFOWRITEPTR, pointers, 3) != 3)
+    return (0);
+
+  uint16_t pending = (pointers[0] - pointers[2]) & (MAX30102_FIFO_DEPTH - 1);
+  if (pending == 0 && pointers[1] != 0)
+    pending = MAX30102_FIFO_DEPTH;
+  bool all = (pending <= maxSamples);
+  if (!all)
+    pending = maxSamples;
+
+  //Every chunk is a whole number of samples, so a sample never spans two reads
+  uint16_t perChunk = I2C_BUFFER_LENGTH / bytesPerSample;
+  uint16_t done = 0;
+
+  while (done < pending)
+  {
+    uint16_t count = pending - done;
+    if (count > perChunk)
+      count = perChunk;
+
+    size_t len = count * bytesPerSample;
+    if (_i2c.readRegs(MAX30105_FIFODATA, buf, len) != len)
+      break;
+
+    const uint8_t *p = buf;
+    for (uint16_t i = 0; i < count; i++)
+    {
+      max30102_sample_t sample;
+      sample.red = fifoChannel(p);
+      sample.ir = activeLEDs > 1 ? fifoChannel(p + 3) : 0;
+      sample.green = activeLEDs > 2 ? fifoChannel(p + 6) : 0;
+      p += bytesPerSample;
+      sink(ctx, sample);
+    }
+    done += count;
+  }
+
+  //OVF_COUNTER is only cleared once FIFO data has been read; counting it
+  //after a failed read would count the same overflow again next time
+  if (done > 0)
+    fifoOverflows += pointers[1];
+  if (complete != NULL)
+    *complete = all && done == pending;
+  return (done);
+}
+
+/**
+  * @brief  INT引脚中断：唤醒读取任务
+  * @parameter arg: MAX30102实例
+  * @retval void
+  */
+void IRAM_ATTR MAX30102::onAlmostFull(void *arg)
+{
+  MAX30102 *sensor = static_cast<MAX30102 *>(arg);
+  BaseType_t woken = pdFALSE;
+
+  vTaskNotifyGiveFromISR(sensor->streamTask, &woken);
+  if (woken == pdTRUE)
+    portYIELD_FROM_ISR();
+}
+
+/**
+  * @brief  读取任务：每次A_FULL中断一次性读空FIFO到样本环形缓冲区
+  * @parameter arg: MAX30102实例
+  * @retval void
+  */
+void MAX30102::streamLoop(void *arg)
+{
+  MAX30102 *sensor = static_cast<MAX30102 *>(arg);
+  TickType_t wait = portMAX_DELAY;
+
+  while (1)
+  {
+    ulTaskNotifyTake(pdTRUE, wait);
+    if (!sensor->streaming)
+      break;
+
+    //Reading INT_STATUS1 releases INT first, so the next A_FULL is a fresh falling edge
+    sensor->getINT1();
+    //Always empty the whole FIFO: samples left there would keep it above the
+    //threshold and A_FULL would never fire again. The ring drops what it has
+    //no room for and counts it in getStreamDrops().
+    bool complete;
+    uint32_t drops = sensor->ring.getOverruns();
+    uint16_t n = sensor->drainFIFO(MAX30102_FIFO_DEPTH, pushToRing<MAX30102_STREAM_DEPTH>, &sensor->ring, &complete);
+    if (n > sensor->ring.getOverruns() - drops && sensor->streamConsumer != NULL)
+      xTaskNotifyGive(sensor->streamConsumer);
+    //A failed read may have left the FIFO full without a new edge to come: poll it again soon
+    wait = complete ? portMAX_DELAY : pdMS_TO_TICKS(MAX30102_STREAM_RETRY_MS);
+  }
+
+  sensor->streamTask = NULL;
+  vTaskDelete(NULL);
+}
+
+/**
+  * @brief  启动中断采集：A_FULL中断 -> 读取任务 -> 样本环形缓冲区，需先调用setup()
+  * @parameter intPin: 接MAX30102 INT引脚的GPIO(开漏，低电平有效)
+  * @parameter freeSlots: FIFO剩余多少空位时触发中断，1~15，越小每次读取的样本越多
+  *         不能为0：FIFO满32个样本时写指针等于读指针且溢出计数为0，与空无法区分
+  * @parameter priority: 读取任务优先级
+  * @parameter core: 读取任务所在的核
+  * @retval 成功返回0，失败返回-1
+  */
+int MAX30102::startStream(uint8_t intPin, uint8_t freeSlots, UBaseType_t priority, BaseType_t core)
+{
+  if (streaming || activeLEDs == 0 || freeSlots == 0 || freeSlots > 0x0F)
+    return (-1);
+
+  ring.clear();
+  streamPin = intPin;
+  streaming = true;
+
+  if (xTaskCreatePinnedToCore(streamLoop, "max30102", 2048, this, priority, &streamTask, core) != pdPASS)
+  {
+    streaming = false;
+    streamTask = NULL;
+    return (-1);
+  }
+
+  setFIFOAlmostFull(freeSlots);
+  getINT1();
+  enableAFULL();
+
+  pinMode(streamPin, INPUT_PULLUP);
+  attachInterruptArg(streamPin, onAlmostFull, this, FALLING);
+  //Already past the threshold before the interrupt was attached: no edge will come
+  if (digitalRead(streamPin) == LOW)
+    xTaskNotifyGive(streamTask);
+  return (0);
+}
+
+/**
+  * @brief  停止中断采集并等待读取任务退出
+  * @parameter void
+  * @retval void
+  */
+void MAX30102::stopStream(void)
+{
+  if (!streaming)
+    return;
+
+  detachInterrupt(streamPin);
+  disableAFULL();
+  streaming = false;
+  xTaskNotifyGive(streamTask);
+  while (streamTask != NULL)
+    delay(1);
+}
+
+/**
+  * @brief  从样本环形缓冲区取出至多maxSamples个样本
+  * @parameter dest: 样本数组
+  * @parameter maxSamples: 数组容量
+  * @retval 取出的样本数
+  */
+uint16_t MAX30102::readStream(max30102_sample_t *dest, uint16_t maxSamples)
+{
+  uint16_t n = 0;
+
+  while (n < maxSamples && ring.pop(&dest[n]))
+    n++;
+  return (n);
+}
+
+/**
+  * @brief  不阻塞地开始一次check()：总线任务读取FIFO指针并读出新样本
+  * @parameter void
+  * @retval 成功排队返回true
+  */
+bool MAX30102::startCheck(void)
+{
+  if (checkRunning)
+    return (false);
+
+  I2C_STATS_XFER_SITE(&checkXfer, "MAX30102::startCheck");
+  checkRunning = true;
+  if (!_i2c.submitReadRegs(&checkXfer, MAX30105_FIFOWRITEPTR, checkPointers, 3, onCheckPointers, this))
+  {
+    checkRunning = false;
+    return (false);
+  }
+  return (true);
+}
+
+/**
+  * @brief  startCheck()的结果，完成前不要访问sense数据
+  * @parameter void
+  * @retval 仍在进行返回-1，否则返回获得的新样本数
+  */
+int16_t MAX30102::collectCheck(void)
+{
+  if (checkRunning)
+    return (-1);
+  return (checkSamples);
+}
+
+/**
+  * @brief  FIFO指针读取完成（在总线任务中运行），把FIFO数据的读取排为下一个传输，
+  *         不在回调里阻塞读取，以免耽误总线上排队的其他传输
+  */
+void MAX30102::onCheckPointers(I2CTransfer *xfer, void *arg)
+{
+  MAX30102 *sensor = (MAX30102 *)arg;
+  uint16_t numberOfSamples = (sensor->checkPointers[0] - sensor->checkPointers[2]) & (MAX30102_FIFO_DEPTH - 1);
+
+  if (xfer->done() && numberOfSamples > 0)
+  {
+    uint8_t reg = MAX30105_FIFODATA;
+    size_t len = numberOfSamples * sensor->activeLEDs * 3;
+
+    I2C_STATS_XFER_SITE(&sensor->checkDataXfer, "MAX30102::startCheck");
+    if (sensor->_i2c.submit(&sensor->checkDataXfer, &reg, 1, sensor->checkData, len, 0, onCheckData, sensor))
+      return;
+  }
+  sensor->checkSamples = 0;
+  sensor->checkRunning = false;
+}
+
+/**
+  * @brief  FIFO数据读取完成（在总线任务中运行），存入sense数据
+  */
+void MAX30102::onCheckData(I2CTransfer *xfer, void *arg)
+{
+  MAX30102 *sensor = (MAX30102 *)arg;
+  uint8_t bytesPerSample = sensor->activeLEDs * 3;
+  uint16_t numberOfSamples = xfer->received / bytesPerSample;
+  const uint8_t *p = sensor->checkData;
+
+  for (uint16_t i = 0; i < numberOfSamples; i++)
+  {
+    sensor->sense.head++; //Advance the head of the storage struct
+    sensor->sense.head %= STORAGE_SIZE; //Wrap condition
+    sensor->sense.red[sensor->sense.head] = fifoChannel(p);
+    if (sensor->activeLEDs > 1)
+      sensor->sense.IR[sensor->sense.head] = fifoChannel(p + 3);
+    if (sensor->activeLEDs > 2)
+      sensor->sense.green[sensor->sense.head] = fifoChannel(p + 6);
+    p += bytesPerSample;
+  }
+
+  //OVF_COUNTER is only cleared once FIFO data has actually been read
+  if (numberOfSamples > 0)
+    sensor->fifoOverflows += sensor->checkPointers[1];
+  sensor->checkSamples = numberOfSamples;
+  sensor->checkRunning = false;
+}
+
+/**
+  * @brief  读出FIFO中读指针到写指针之间的样本
+  * @parameter readPointer: FIFO_RD_PTR
+  * @parameter writePointer: FIFO_WR_PTR
+  * @retval numberOfSamples: 返回获得的新样本数
+  */
+uint16_t MAX30102::readFIFO(byte readPointer, byte writePointer)
 {
   //Read register FIDO_DATA in (3-byte * number of active LED) chunks
   //Until FIFO_RD_PTR = FIFO_WR_PTR
 
-  byte readPointer = getReadPointer();
-  byte writePointer = getWritePointer();
-
   int numberOfSamples = 0;
 
   //Do we have new data?
@@ -682,14 +1019,11 @@ uint16_t MAX30102::check(void)
     //For this example we are just doing Red and IR (3 bytes each)
     int bytesLeftToRead = numberOfSamples * activeLEDs * 3;
 
-    //Get ready to read a burst of data from the FIFO register
-    _i2cPort->beginTransmission(MAX30105_ADDRESS);
-    _i2cPort->write(MAX30105_FIFODATA);
-    _i2cPort->endTransmission();
-
     //We may need to read as many as 288 bytes so we read in blocks no larger than I2C_BUFFER_LENGTH
-    //I2C_BUFFER_LENGTH changes based on the platform. 64 bytes for SAMD21, 32 bytes for Uno.
-    //Wire.requestFrom() is limited to BUFFER_LENGTH which is 32 on the Uno
+    //I2C_BUFFER_LENGTH changes based on the platform. 128 bytes for ESP32, 64 bytes for SAMD21, 32 bytes for Uno.
+    //Every block re-addresses FIFO_DATA, the FIFO read pointer advances on its own
+    uint8_t buf[I2C_BUFFER_LENGTH];
+
     while (bytesLeftToRead > 0)
     {
       int toGet = bytesLeftToRead;
@@ -705,8 +1039,13 @@ uint16_t MAX30102::check(void)
       bytesLeftToRead -= toGet;
 
       //Request toGet number of bytes from sensor
-      _i2cPort->requestFrom(MAX30105_ADDRESS, toGet);
-      
+      if (_i2c.readRegs(MAX30105_FIFODATA, buf, toGet) != (size_t)toGet)
+      {
+        numberOfSamples -= (bytesLeftToRead + toGet) / (activeLEDs * 3); //Not read
+        break;
+      }
+
+      uint8_t *p = buf;
       while (toGet > 0)
       {
         sense.head++; //Advance the head of the storage struct
@@ -717,9 +1056,9 @@ uint16_t MAX30102::check(void)
 
         //Burst read three bytes - RED
         temp[3] = 0;
-        temp[2] = _i2cPort->read();
-        temp[1] = _i2cPort->read();
-        temp[0] = _i2cPort->read();
+        temp[2] = *p++;
+        temp[1] = *p++;
+        temp[0] = *p++;
 
         //Convert array to long
         memcpy(&tempLong, temp, sizeof(tempLong));
@@ -732,9 +1071,9 @@ uint16_t MAX30102::check(void)
         {
           //Burst read three more bytes - IR
           temp[3] = 0;
-          temp[2] = _i2cPort->read();
-          temp[1] = _i2cPort->read();
-          temp[0] = _i2cPort->read();
+          temp[2] = *p++;
+          temp[1] = *p++;
+          temp[0] = *p++;
 
           //Convert array to long
           memcpy(&tempLong, temp, sizeof(tempLong));
@@ -748,9 +1087,9 @@ uint16_t MAX30102::check(void)
         {
           //Burst read three more bytes - Green
           temp[3] = 0;
-          temp[2] = _i2cPort->read();
-          temp[1] = _i2cPort->read();
-          temp[0] = _i2cPort->read();
+          temp[2] = *p++;
+          temp[1] = *p++;
+          temp[0] = *p++;
 
           //Convert array to long
           memcpy(&tempLong, temp, sizeof(tempLong));
@@ -820,14 +1159,11 @@ void MAX30102::bitMask(uint8_t reg, uint8_t mask, uint8_t thing)
   * @retval  成功返回读取的数据，失败返回0
   */
 uint8_t MAX30102::readRegister8(uint8_t address, uint8_t reg) {
-  _i2cPort->beginTransmission(address);
-  _i2cPort->write(reg);
-  _i2cPort->endTransmission(false);
+  uint8_t value;
 
-  _i2cPort->requestFrom((uint8_t)address, (uint8_t)1); // Request 1 byte
-  if (_i2cPort->available())
+  if (_i2c.getBus().readReg(address, reg, &value, _i2c.getClock()))
   {
-    return(_i2cPort->read());
+    return(value);
   }
 
   return (0); //Fail
@@ -869,10 +1205,9 @@ void MAX30102::caldata(double *avered,double *aveir,double *sumirrms,double *sum
   */
 void MAX30102::get_ESPO2(int32_t ir, double *avered,double *aveir,double *sumirrms,double *sumredrms, double *SpO2, double *ESpO2)
 {
-  static int i=0;
   double FSpO2 = 0.7; //filter factor for estimated SpO2
-  i++;
-   if(i%100==0){
+  espo2Count++;
+   if(espo2Count%MAX30102_SPO2_WINDOW==0){
       double R = (sqrt((*sumredrms)) / (*avered)) / (sqrt((*sumirrms)) / (*aveir));
       
       (*SpO2) = -23.3 * (R - 0.4) + 100; //http://ww1.microchip.com/downloads/jp/AppNotes/00001525B_JP.pdf
@@ -880,10 +1215,137 @@ void MAX30102::get_ESPO2(int32_t ir, double *avered,double *aveir,double *sumirr
       
       (*sumredrms) = 0.0; 
       (*sumirrms) = 0.0; 
-      i=0;
+      espo2Count=0;
     }  
 }
 
+#define SPO2_DC_ALPHA       3277 //1 - 0.95 in Q16, same low pass as caldata()
+#define SPO2_RATIO_STEPS    470  //R in 1/100, up to where SpO2 reaches 0
+
+//SpO2 in 0.1 % for R = 0.00 .. 4.69, 100 - 23.3 * (R - 0.4) as in get_ESPO2()
+//http://ww1.microchip.com/downloads/jp/AppNotes/00001525B_JP.pdf
+static const int16_t spo2_ratio_table[SPO2_RATIO_STEPS] = {
+  1093, 1091, 1089, 1086, 1084, 1082, 1079, 1077, 1075, 1072, 1070, 1068, 1065, 1063, 1061,
+  1058, 1056, 1054, 1051, 1049, 1047, 1044, 1042, 1040, 1037, 1035, 1033, 1030, 1028, 1026,
+  1023, 1021, 1019, 1016, 1014, 1012, 1009, 1007, 1005, 1002, 1000,  998,  995,  993,  991,
+   988,  986,  984,  981,  979,  977,  974,  972,  970,  967,  965,  963,  960,  958,  956,
+   953,  951,  949,  946,  944,  942,  939,  937,  935,  932,  930,  928,  925,  923,  921,
+   918,  916,  914,  911,  909,  907,  904,  902,  900,  897,  895,  893,  890,  888,  886,
+   884,  881,  879,  877,  874,  872,  870,  867,  865,  863,  860,  858,  856,  853,  851,
+   849,  846,  844,  842,  839,  837,  835,  832,  830,  828,  825,  823,  821,  818,  816,
+   814,  811,  809,  807,  804,  802,  800,  797,  795,  793,  790,  788,  786,  783,  781,
+   779,  776,  774,  772,  769,  767,  765,  762,  760,  758,  755,  753,  751,  748,  746,
+   744,  741,  739,  737,  734,  732,  730,  727,  725,  723,  720,  718,  716,  713,  711,
+   709,  706,  704,  702,  699,  697,  695,  692,  690,  688,  685,  683,  681,  678,  676,
+   674,  671,  669,  667,  664,  662,  660,  657,  655,  653,  651,  648,  646,  644,  641,
+   639,  637,  634,  632,  630,  627,  625,  623,  620,  618,  616,  613,  611,  609,  606,
+   604,  602,  599,  597,  595,  592,  590,  588,  585,  583,  581,  578,  576,  574,  571,
+   569,  567,  564,  562,  560,  557,  555,  553,  550,  548,  546,  543,  541,  539,  536,
+   534,  532,  529,  527,  525,  522,  520,  518,  515,  513,  511,  508,  506,  504,  501,
+   499,  497,  494,  492,  490,  487,  485,  483,  480,  478,  476,  473,  471,  469,  466,
+   464,  462,  459,  457,  455,  452,  450,  448,  445,  443,  441,  438,  436,  434,  431,
+   429,  427,  424,  422,  420,  418,  415,  413,  411,  408,  406,  404,  401,  399,  397,
+   394,  392,  390,  387,  385,  383,  380,  378,  376,  373,  371,  369,  366,  364,  362,
+   359,  357,  355,  352,  350,  348,  345,  343,  341,  338,  336,  334,  331,  329,  327,
+   324,  322,  320,  317,  315,  313,  310,  308,  306,  303,  301,  299,  296,  294,  292,
+   289,  287,  285,  282,  280,  278,  275,  273,  271,  268,  266,  264,  261,  259,  257,
+   254,  252,  250,  247,  245,  243,  240,  238,  236,  233,  231,  229,  226,  224,  222,
+   219,  217,  215,  212,  210,  208,  205,  203,  201,  198,  196,  194,  191,  189,  187,
+   185,  182,  180,  178,  175,  173,  171,  168,  166,  164,  161,  159,  157,  154,  152,
+   150,  147,  145,  143,  140,  138,  136,  133,  131,  129,  126,  124,  122,  119,  117,
+   115,  112,  110,  108,  105,  103,  101,   98,   96,   94,   91,   89,   87,   84,   82,
+    80,   77,   75,   73,   70,   68,   66,   63,   61,   59,   56,   54,   52,   49,   47,
+    45,   42,   40,   38,   35,   33,   31,   28,   26,   24,   21,   19,   17,   14,   12,
+    10,    7,    5,    3,    0
+};
+
+/**
+  * @brief  64位整数平方根，向下取整
+  */
+static uint32_t isqrt64(uint64_t x)
+{
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while (bit > x)
+    bit >>= 2;
+  while (bit != 0)
+  {
+    if (x >= root + bit)
+    {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+      root >>= 1;
+    bit >>= 2;
+  }
+  return ((uint32_t)root);
+}
+
+/**
+  * @brief  初始化定点血氧饱和度计算的状态
+  * @parameter state:  指向状态的指针
+  * @parameter ESpO2:  平均血氧饱和度初始值，单位0.1%
+  * @retval  void
+  */
+void MAX30102::initSpO2(max30102_spo2_t *state, int16_t ESpO2)
+{
+  memset(state, 0, sizeof(*state));
+  state->ESpO2 = ESpO2;
+}
+
+/**
+  * @brief  定点计算血氧饱和度，每个样本调用一次，同caldata()加get_ESPO2()，但不用浮点
+  *         每MAX30102_SPO2_WINDOW个样本：R = (AC红/DC红) / (AC红外/DC红外)，
+  *         查表spo2_ratio_table得到SpO2，再做0.7的低通滤波
+  * @parameter state:  指向状态的指针，见initSpO2()
+  * @parameter red:  红色值
+  * @parameter ir:  红外值
+  * @retval  得到新的SpO2和ESpO2时返回true
+  */
+bool MAX30102::calSpO2(max30102_spo2_t *state, int32_t red, int32_t ir)
+{
+  int32_t red8 = red << 8;
+  int32_t ir8 = ir << 8;
+
+  //Start the DC levels at the first sample instead of ramping up from 0
+  if (state->aveRed == 0 && state->aveIR == 0)
+  {
+    state->aveRed = red8;
+    state->aveIR = ir8;
+  }
+  state->aveRed += ((int64_t)(red8 - state->aveRed) * SPO2_DC_ALPHA) >> 16;
+  state->aveIR += ((int64_t)(ir8 - state->aveIR) * SPO2_DC_ALPHA) >> 16;
+
+  int32_t acRed = (red8 - state->aveRed) >> 4;
+  int32_t acIR = (ir8 - state->aveIR) >> 4;
+  state->sumRedRms += (int64_t)acRed * acRed;
+  state->sumIRRms += (int64_t)acIR * acIR;
+
+  if (++state->count < MAX30102_SPO2_WINDOW)
+    return false;
+
+  uint32_t rmsRed = isqrt64(state->sumRedRms);
+  uint32_t rmsIR = isqrt64(state->sumIRRms);
+  state->sumRedRms = 0;
+  state->sumIRRms = 0;
+  state->count = 0;
+  if (rmsIR == 0 || state->aveRed <= 0 || state->aveIR <= 0)
+    return false;
+
+  //R in 1/100, rounded
+  uint64_t num = (uint64_t)rmsRed * (uint32_t)state->aveIR * 100;
+  uint64_t den = (uint64_t)rmsIR * (uint32_t)state->aveRed;
+  uint64_t ratio = (num + den / 2) / den;
+  if (ratio >= SPO2_RATIO_STEPS)
+    ratio = SPO2_RATIO_STEPS - 1;
+
+  state->SpO2 = spo2_ratio_table[ratio];
+  state->ESpO2 = (7 * state->ESpO2 + 3 * state->SpO2) / 10; //low pass filter
+  return true;
+}
+
 /**
   * @brief  得到心率和平均心率
   * @parameter irValue:  指向红色值的指针
@@ -893,16 +1355,13 @@ void MAX30102::get_ESPO2(int32_t ir, double *avered,double *aveir,double *sumirr
   */
 bool MAX30102::get_avgBPM(int32_t *irValue,  int *beatAvg, float *beatsPerMinute)
 {
-    static byte rateSpot;
-   static byte rates[4];                  //Array of heart rates
-   static long lastBeat;                  //Time at which the last beat occurred 
   if((*irValue)<500)
   {
     Serial.println("No finger");
     return false;
   }
   
-  if (checkForBeat((*irValue)) == true)
+  if (beat.check((*irValue)) == true)
   {
     //We sensed a beat!
     long delta = millis() - lastBeat;
@@ -913,18 +1372,17 @@ bool MAX30102::get_avgBPM(int32_t *irValue,  int *beatAvg, float *beatsPerMinute
     if ((*beatsPerMinute) < 255 && (*beatsPerMinute) > 20)
     {
       rates[rateSpot++] = (byte)(*beatsPerMinute); //Store this reading in the array
-      //(*rateSpot) %= RATE_SIZE; //Wrap variable
-      rateSpot %= 4; //Wrap variable
+      rateSpot %= MAX30102_RATE_SIZE; //Wrap variable
       //Take average of readings
       *beatAvg = 0;
-      for (byte x = 0 ; x < 4 ; x++)
+      for (byte x = 0 ; x < MAX30102_RATE_SIZE ; x++)
         *beatAvg += rates[x];
-      //*beatAvg /= RATE_SIZE;
-      *beatAvg /= 4;
+      *beatAvg /= MAX30102_RATE_SIZE;
     }
     
     return true;
   }
+  return false;
 }
 
 /**
@@ -935,8 +1393,5 @@ bool MAX30102::get_avgBPM(int32_t *irValue,  int *beatAvg, float *beatsPerMinute
   * @retval  void
   */
 void MAX30102::writeRegister8(uint8_t address, uint8_t reg, uint8_t value) {
-  _i2cPort->beginTransmission(address);
-  _i2cPort->write(reg);
-  _i2cPort->write(value);
-  _i2cPort->endTransmission();
+  _i2c.getBus().writeReg(address, reg, value, _i2c.getClock());
 }
@@ -267,12 +267,7 @@ unsigned char initRegisterArray[][2] = {	// Initial Gesture
   */  
 uint8_t PAJ7620::paj7620WriteReg(uint8_t addr, uint8_t cmd)
 {
-	char i = 1;
-	Wire.beginTransmission(PAJ7620_ID);		// start transmission to device 
-	//write cmd
-	Wire.write(addr);						// send register address
-	Wire.write(cmd);						// send value to write
-    i = Wire.endTransmission();  		    // end transmission
+	char i = i2c.writeReg(addr, cmd) ? 0 : 1;	// register address, then value
 	if(0 != i)
     {
 		Serial.print("end error!!!\n");
@@ -290,31 +285,10 @@ uint8_t PAJ7620::paj7620WriteReg(uint8_t addr, uint8_t cmd)
   */
 uint8_t PAJ7620::paj7620ReadReg(uint8_t addr, uint8_t qty, uint8_t *data)
 {
-	uint8_t error;
-	Wire.beginTransmission(PAJ7620_ID);
-	Wire.write(addr);
-	error = Wire.endTransmission();
-
-	if(0 != error)
+	if(i2c.readRegs(addr, data, qty) != qty)
     {
 		Serial.print("end error!!!\n");
-		return error; //return error code
-	}
-	
-	Wire.requestFrom((int)PAJ7620_ID, (int)qty);
-
-	while (Wire.available()) 
-	{
-		*data = Wire.read();
-
-/*#ifdef debug    //debug
-    Serial.print("addr:");
-    Serial.print(addr++, HEX);
-    Serial.print("  data:");
-    Serial.println(*data, HEX);
-#endif
-
-	data++;*/
+		return 1; //return error code
 	}
 	return 0;
 }
@@ -352,8 +326,6 @@ uint8_t PAJ7620::paj7620Init(void)
 	//wakeup the sensor
 	delayMicroseconds(700);	//Wait 700us for PAJ7620U2 to stabilize	
 	
-	Wire.begin();
-	
 	Serial.println("INIT SENSOR...");
 
 	paj7620SelectBank(BANK0);
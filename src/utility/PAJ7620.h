@@ -32,6 +32,7 @@
 #define __PAJ7620_H__
 
 #include <Wire.h>
+#include "I2CBus.h"
 #define BIT(x)  1 << x
 
 // REGISTER DESCRIPTION
@@ -99,12 +100,15 @@ typedef enum {
 
 class PAJ7620{
 	public:
-		PAJ7620(){}
+		PAJ7620() : i2c(PAJ7620_ID) {}
 		~PAJ7620(){}
+		void setBus(I2CBus& bus, uint32_t clock = 0) { i2c.setBus(bus); i2c.setClock(clock); }
 		uint8_t paj7620Init(void);
 		uint8_t paj7620WriteReg(uint8_t addr, uint8_t cmd);
 		uint8_t paj7620ReadReg(uint8_t addr, uint8_t qty, uint8_t *data);
 		void paj7620SelectBank(bank_e bank);
+	private:
+		I2CDevice i2c;
 };
 
 
@@ -0,0 +1,77 @@
+#ifndef _SAMPLE_RING_H_
+#define _SAMPLE_RING_H_
+
+#include <stdint.h>
+#include <atomic>
+
+/*
+ * Lock-free single-producer/single-consumer ring buffer.
+ *
+ * Exactly one task (or ISR) may call push() and exactly one task may call
+ * pop(); the two sides only share the head/tail indices, so neither ever
+ * blocks the other. N must be a power of two.
+ */
+template <typename T, uint32_t N>
+class SampleRing {
+  static_assert(N != 0 && (N & (N - 1)) == 0, "SampleRing capacity must be a power of two");
+
+ public:
+  SampleRing() : head(0), tail(0), overruns(0) {}
+
+  /* Producer: store one item, or drop it and count an overrun when full */
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N) {
+      overruns.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    buf[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* Consumer: take the oldest item, false when empty */
+  bool pop(T* item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t)
+      return false;
+    *item = buf[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* Consumer: take up to maxItems of the oldest items, returns how many */
+  uint32_t pop(T* items, uint32_t maxItems) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t n = head.load(std::memory_order_acquire) - t;
+    if (n > maxItems)
+      n = maxItems;
+    for (uint32_t i = 0; i < n; i++)
+      items[i] = buf[(t + i) & (N - 1)];
+    tail.store(t + n, std::memory_order_release);
+    return n;
+  }
+
+  uint32_t available(void) const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  uint32_t capacity(void) const { return N; }
+
+  /* Number of items dropped by push() because the consumer fell behind */
+  uint32_t getOverruns(void) const { return overruns.load(std::memory_order_relaxed); }
+
+  /* Only safe while the producer is stopped */
+  void clear(void) {
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    overruns.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  T buf[N];
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> tail;
+  std::atomic<uint32_t> overruns;
+};
+
+#endif
@@ -4,35 +4,50 @@
 
 
 /**
-  * @brief  Read brightness data once
+  * @brief  Read brightness data once, blocks for the measurement time
   * @param  void
   * @retval none
   */
 void BH1750FVI::BH1750FVI_READ_DATA(void)
 {
-	Wire.beginTransmission(BH1750FVI_ADDR);                       
-    Wire.write(ONE_TIME_H_RESOLUTION_MODE);                       
-	 uint8_t tmp = Wire.endTransmission();                        
-   if (tmp)                                                     
-   	{
-        	Serial.println("endTransmission Error!!!!");        
-            exit(0); 
-    	}
+    if (!BH1750FVI_START())
+        return;
+    i2c.wait(&xfer);
+    BH1750FVI_COLLECT();
+}
+
+/**
+  * @brief  Start a one-time measurement without blocking; the bus task
+            fetches the result BH1750FVI_H_RES_TIME_US later
+  * @param  void
+  * @retval true if the measurement was queued
+  */
+bool BH1750FVI::BH1750FVI_START(void)
+{
+	uint8_t cmd = ONE_TIME_H_RESOLUTION_MODE;
+	I2C_STATS_XFER_SITE(&xfer, "BH1750FVI_START");
+    return i2c.submit(&xfer, &cmd, 1, buf, 2, BH1750FVI_H_RES_TIME_US);
+}
 
-    Wire.requestFrom(BH1750FVI_ADDR, 2*sizeof(uint8_t));       
-    for (uint8_t i = 0; i < 2; ++i)                             
-        buf[i] = Wire.read();
-    delay(1);
-    
-    if (Wire.available() != 0)                                  
-    {  
-        Serial.println("available error!!!!");                  
-        exit(0);
+/**
+  * @brief  Convert the result of BH1750FVI_START
+  * @param  void
+  * @retval true if a new value was stored
+  */
+bool BH1750FVI::BH1750FVI_COLLECT(void)
+{
+    if (!xfer.done())
+    {
+        if (!xfer.pending())
+            Serial.println("endTransmission Error!!!!");
+        return false;
     }
+
 	    dis_data = buf[0];
     	dis_data = (dis_data<<8)+buf[1];                          
     	temp = (float)dis_data/1.2;                               //Get the integer part
     	temp += (float)((int)(10*dis_data/1.2)%10)/10;            //Get the fractional part and get the complete data
+    return true;
 }
 
 /**
@@ -2,6 +2,7 @@
 #define __BH1750FVI_DRIVER_H
 
 #include <Wire.h>
+#include "I2CBus.h"
 #define BH1750FVI_ADDR                  0x23		//IIC correspondence address of bh1750fvi 
 
 /*
@@ -15,18 +16,25 @@
  */
 
 #define ONE_TIME_H_RESOLUTION_MODE 0x20         
+#define BH1750FVI_H_RES_TIME_US    180000       //Max H-Resolution measurement time
 
 class BH1750FVI{
 	private:
 	  uint8_t buf[4] = {0};
     uint32_t dis_data;               
     float temp;
+    I2CDevice i2c;
+    I2CTransfer xfer;
 	
 	public:
-		BH1750FVI(){}
+		BH1750FVI() : dis_data(0), temp(0), i2c(BH1750FVI_ADDR) {}
+		void setBus(I2CBus& bus, uint32_t clock = 0) { i2c.setBus(bus); i2c.setClock(clock); }
 		~BH1750FVI(){}
     float get_Data(void);        
 		void BH1750FVI_READ_DATA(void);	
+		bool BH1750FVI_START(void);
+		bool BH1750FVI_BUSY(void) { return xfer.pending(); }
+		bool BH1750FVI_COLLECT(void);
 };
 
 #endif /* __BH1750FVI_DRIVER_H */
@@ -3,14 +3,14 @@
 #include <Wire.h>
 
 
-BMM150::BMM150()
+BMM150::BMM150() : streaming(false), stream_pin(0), stream_task(NULL), stream_consumer(NULL), irq_timestamp(0), i2c_dev(BMM150_I2C_Address)
 {
+	memset(&trim_data, 0, sizeof(trim_data));
+	memset(&comp_consts, 0, sizeof(comp_consts));
 }
 
-int8_t BMM150::initialize(void)
-{ 
-  Wire.begin();
-
+int8_t BMM150::initialize(uint8_t preset_mode, uint8_t op_mode)
+{
 	/* Power up the sensor from suspend to sleep mode */
   set_op_mode(BMM150_SLEEP_MODE);
 	delay(BMM150_START_UP_TIME);
@@ -24,21 +24,170 @@ int8_t BMM150::initialize(void)
 	/* Function to update trim values */
 	read_trim_registers();
 
-  /* Setting the power mode as normal */
-  set_op_mode(BMM150_NORMAL_MODE);
+	if (op_mode != BMM150_NORMAL_MODE && op_mode != BMM150_FORCED_MODE)
+		return BMM150_E_INVALID_CONFIG;
 
-	/* Setting the preset mode as Low power mode 
+  /* Setting the power mode as normal, forced mode stays in sleep
+  until a conversion is triggered */
+  set_op_mode(op_mode == BMM150_NORMAL_MODE ? BMM150_NORMAL_MODE : BMM150_SLEEP_MODE);
+
+	/* Setting the preset mode, by default Low power mode
 	i.e. data rate = 10Hz XY-rep = 1 Z-rep = 2*/
-	set_presetmode(BMM150_PRESETMODE_LOWPOWER);
-	// set_presetmode(BMM150_HIGHACCURACY_REPZ);
+	set_presetmode(preset_mode);
 	
   return BMM150_OK;
 }
 
+uint32_t BMM150::get_conversion_time_us()
+{
+	uint32_t nxy = 1 + 2 * (uint32_t)settings.xy_rep;
+	uint32_t nz = 1 + (uint32_t)settings.z_rep;
+
+	return BMM150_CONV_TIME_XY_US * nxy + BMM150_CONV_TIME_Z_US * nz + BMM150_CONV_TIME_BASE_US;
+}
+
+int8_t BMM150::read_mag_data_forced()
+{
+	uint32_t conv_us = get_conversion_time_us();
+	uint32_t start;
+
+	/* Sensor is in sleep mode, no start-up delay needed */
+	write_op_mode(BMM150_FORCED_MODE);
+
+	/* delay() yields to other tasks for the bulk of the conversion */
+	delay(conv_us / 1000);
+	delayMicroseconds(conv_us % 1000);
+
+	start = micros();
+	while (!(i2c_read(BMM150_DATA_READY_STATUS) & BMM150_DRDY_STATUS_MSK)) {
+		if (micros() - start > BMM150_DRDY_TIMEOUT_US)
+			return BMM150_E_TIMEOUT;
+		delayMicroseconds(100);
+	}
+
+	read_mag_data();
+	return BMM150_OK;
+}
+
+void BMM150::set_drdy_interrupt(bool enable)
+{
+	uint8_t reg_data;
+	uint8_t drdy_en = enable ? 1 : 0;
+
+	reg_data = i2c_read(BMM150_AXES_ENABLE_ADDR);
+	/* BMM150_SET_BITS does not parenthesize its data argument */
+	reg_data = BMM150_SET_BITS(reg_data, BMM150_DRDY_EN, drdy_en);
+	reg_data = BMM150_SET_BITS(reg_data, BMM150_DRDY_POLARITY, 1);
+	i2c_write(BMM150_AXES_ENABLE_ADDR, reg_data);
+}
+
+void IRAM_ATTR BMM150::on_drdy(void *arg)
+{
+	BMM150 *mag = static_cast<BMM150 *>(arg);
+	BaseType_t woken = pdFALSE;
+
+	mag->irq_timestamp = micros();
+	vTaskNotifyGiveFromISR(mag->stream_task, &woken);
+	if (woken == pdTRUE)
+		portYIELD_FROM_ISR();
+}
+
+/*
+ * @brief Reader task: one burst read per DRDY edge into the sample ring.
+ * Reading the data registers clears DRDY.
+ */
+void BMM150::stream_loop(void *arg)
+{
+	BMM150 *mag = static_cast<BMM150 *>(arg);
+	struct bmm150_raw_mag_data raw;
+	struct bmm150_sample sample;
+	struct bmm150_rhall_terms terms; /* Only this task's, reused while rhall holds */
+
+	terms.rhall_valid = 0;
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (!mag->streaming)
+			break;
+
+		sample.timestamp = mag->irq_timestamp;
+		mag->read_raw_mag_data(&raw);
+		mag->compensate_q4(&raw, &sample.mag, &terms);
+
+		mag->ring.push(sample);
+		if (mag->stream_consumer != NULL)
+			xTaskNotifyGive(mag->stream_consumer);
+	}
+
+	mag->stream_task = NULL;
+	vTaskDelete(NULL);
+}
+
+int8_t BMM150::start_stream(uint8_t drdy_pin, UBaseType_t priority, BaseType_t core)
+{
+	if (streaming)
+		return BMM150_E_STREAM;
+
+	ring.clear();
+	stream_pin = drdy_pin;
+	streaming = true;
+
+	if (xTaskCreatePinnedToCore(stream_loop, "bmm150", 2048, this, priority, &stream_task, core) != pdPASS) {
+		streaming = false;
+		stream_task = NULL;
+		return BMM150_E_STREAM;
+	}
+
+	set_drdy_interrupt(true);
+	set_op_mode(BMM150_NORMAL_MODE);
+
+	/* DRDY may already be high from an unread sample, a read clears it
+	so the next conversion produces an edge */
+	read_raw_mag_data(&raw_mag_data);
+
+	pinMode(stream_pin, INPUT);
+	attachInterruptArg(stream_pin, on_drdy, this, RISING);
+
+	/* A conversion that finished before the handler was attached left no edge */
+	if (digitalRead(stream_pin))
+		xTaskNotifyGive(stream_task);
+	return BMM150_OK;
+}
+
+void BMM150::stop_stream()
+{
+	if (!streaming)
+		return;
+
+	detachInterrupt(stream_pin);
+	streaming = false;
+	xTaskNotifyGive(stream_task);
+	while (stream_task != NULL)
+		delay(1);
+
+	set_drdy_interrupt(false);
+}
+
 void BMM150::read_mag_data()
+{
+    struct bmm150_rhall_terms terms;
+
+    read_raw_mag_data(&raw_mag_data);
+
+    /* Compensated Mag data in 1/16 micro-tesla */
+    terms.rhall_valid = 0;
+    compensate_q4(&raw_mag_data, &mag_data_q4, &terms);
+
+    /* Compensated Mag data in int16_t format */
+    mag_data.x = q4_to_ut(mag_data_q4.x);
+    mag_data.y = q4_to_ut(mag_data_q4.y);
+    mag_data.z = q4_to_ut(mag_data_q4.z);
+}
+
+void BMM150::read_raw_mag_data(struct bmm150_raw_mag_data *raw)
 {
     int16_t msb_data;
     int8_t reg_data[BMM150_XYZR_DATA_LEN] = {0};
+    I2C_STATS_SITE(i2c_dev.getBus(), "BMM150::read_raw_mag_data");
     
     i2c_read(BMM150_DATA_X_LSB, reg_data, BMM150_XYZR_DATA_LEN);
 
@@ -48,31 +197,145 @@ void BMM150::read_mag_data()
     /* Multiply by 32 to get the shift left by 5 value */
     msb_data = ((int16_t)((int8_t)reg_data[1])) * 32;
     /* Raw mag X axis data */
-    raw_mag_data.raw_datax = (int16_t)(msb_data | reg_data[0]);
+    raw->raw_datax = (int16_t)(msb_data | reg_data[0]);
     /* Mag Y axis data */
     reg_data[2] = BMM150_GET_BITS(reg_data[2], BMM150_DATA_Y);
     /* Shift the MSB data to left by 5 bits */
     /* Multiply by 32 to get the shift left by 5 value */
     msb_data = ((int16_t)((int8_t)reg_data[3])) * 32;
     /* Raw mag Y axis data */
-    raw_mag_data.raw_datay = (int16_t)(msb_data | reg_data[2]);
+    raw->raw_datay = (int16_t)(msb_data | reg_data[2]);
     /* Mag Z axis data */
     reg_data[4] = BMM150_GET_BITS(reg_data[4], BMM150_DATA_Z);
     /* Shift the MSB data to left by 7 bits */
     /* Multiply by 128 to get the shift left by 7 value */
     msb_data = ((int16_t)((int8_t)reg_data[5])) * 128;
     /* Raw mag Z axis data */
-    raw_mag_data.raw_dataz = (int16_t)(msb_data | reg_data[4]);
+    raw->raw_dataz = (int16_t)(msb_data | reg_data[4]);
     /* Mag R-HALL data */
     reg_data[6] = BMM150_GET_BITS(reg_data[6], BMM150_DATA_RHALL);
-    raw_mag_data.raw_data_r = (uint16_t)(((uint16_t)reg_data[7] << 6) | reg_data[6]);
+    raw->raw_data_r = (uint16_t)(((uint16_t)reg_data[7] << 6) | reg_data[6]);
+}
+
+/*
+ * @brief This API compensates count raw samples into micro-tesla.
+ */
+void BMM150::compensate_block(const struct bmm150_raw_mag_data *raw, struct bmm150_mag_data *out, uint16_t count)
+{
+	struct bmm150_mag_data_q4 q4;
+	struct bmm150_rhall_terms terms;
+
+	terms.rhall_valid = 0;
+	for (uint16_t i = 0; i < count; i++) {
+		compensate_q4(&raw[i], &q4, &terms);
+		out[i].x = q4_to_ut(q4.x);
+		out[i].y = q4_to_ut(q4.y);
+		out[i].z = q4_to_ut(q4.z);
+	}
+}
+
+/*
+ * @brief This API compensates count raw samples into 1/16 micro-tesla.
+ */
+void BMM150::compensate_block_q4(const struct bmm150_raw_mag_data *raw, struct bmm150_mag_data_q4 *out, uint16_t count)
+{
+	struct bmm150_rhall_terms terms;
+
+	terms.rhall_valid = 0;
+	for (uint16_t i = 0; i < count; i++)
+		compensate_q4(&raw[i], &out[i], &terms);
+}
+
+/*
+ * @brief This internal API derives the constant parts of the compensation
+ * equations from the trim registers.
+ */
+void BMM150::update_comp_consts()
+{
+	comp_consts.xyz1_16384 = ((int32_t)trim_data.dig_xyz1) * 16384;
+	comp_consts.xy1_128 = (int32_t)(((int16_t)trim_data.dig_xy1) * 128);
+	comp_consts.xy2 = (int32_t)trim_data.dig_xy2;
+	comp_consts.x2_a0 = (int32_t)(((int16_t)trim_data.dig_x2) + ((int16_t)0xA0));
+	comp_consts.y2_a0 = (int32_t)(((int16_t)trim_data.dig_y2) + ((int16_t)0xA0));
+	comp_consts.x1_8 = ((int16_t)trim_data.dig_x1) * 8;
+	comp_consts.y1_8 = ((int16_t)trim_data.dig_y1) * 8;
+	comp_consts.z_valid = (trim_data.dig_z2 != 0) && (trim_data.dig_z1 != 0) && (trim_data.dig_xyz1 != 0);
+}
+
+/*
+ * @brief This internal API computes the parts of the compensation equations
+ * that only depend on the hall resistance, same steps as compensate_x/y/z.
+ * They go to the caller's terms, never to shared driver state, because the
+ * stream task and read_mag_data() may compensate at the same time.
+ */
+void BMM150::update_rhall_terms(uint16_t data_rhall, struct bmm150_rhall_terms *terms)
+{
+	uint16_t rhall0;
+	int16_t retval;
+	int32_t base;
+
+	terms->rhall = data_rhall;
+	terms->rhall_valid = 1;
+
+	/* X/Y: shared between both axes */
+	if (data_rhall != 0)
+		rhall0 = data_rhall;
+	else
+		rhall0 = trim_data.dig_xyz1;
+	terms->xy_valid = (rhall0 != 0);
+	if (terms->xy_valid) {
+		retval = (int16_t)(uint16_t)(((uint16_t)(comp_consts.xyz1_16384 / rhall0)) - ((uint16_t)0x4000));
+		base = (((comp_consts.xy2 * ((((int32_t)retval) * ((int32_t)retval)) / 128))
+			+ (((int32_t)retval) * comp_consts.xy1_128)) / 512) + ((int32_t)0x100000);
+		terms->kx = (base * comp_consts.x2_a0) / 4096;
+		terms->ky = (base * comp_consts.y2_a0) / 4096;
+	}
 
-    /* Compensated Mag X data in int16_t format */
-    mag_data.x = compensate_x(raw_mag_data.raw_datax, raw_mag_data.raw_data_r);
-    /* Compensated Mag Y data in int16_t format */
-    mag_data.y = compensate_y(raw_mag_data.raw_datay, raw_mag_data.raw_data_r);
-    /* Compensated Mag Z data in int16_t format */
-    mag_data.z = compensate_z(raw_mag_data.raw_dataz, raw_mag_data.raw_data_r);
+	/* Z */
+	if (comp_consts.z_valid && (data_rhall != 0)) {
+		int16_t process_comp_z0 = ((int16_t)data_rhall) - ((int16_t)trim_data.dig_xyz1);
+		int32_t process_comp_z3 = ((int32_t)trim_data.dig_z1) * (((int16_t)data_rhall) * 2);
+		int16_t process_comp_z4 = (int16_t)((process_comp_z3 + (32768)) / 65536);
+
+		terms->z_offset = (((int32_t)trim_data.dig_z3) * ((int32_t)(process_comp_z0))) / 4;
+		terms->z_div = trim_data.dig_z2 + process_comp_z4;
+	} else {
+		terms->z_div = 0;
+	}
+}
+
+/*
+ * @brief This internal API compensates one raw sample into 1/16 micro-tesla
+ * using the precomputed constants. terms is refreshed when rhall changes.
+ */
+void BMM150::compensate_q4(const struct bmm150_raw_mag_data *raw, struct bmm150_mag_data_q4 *out,
+			   struct bmm150_rhall_terms *terms)
+{
+	if (!terms->rhall_valid || terms->rhall != raw->raw_data_r)
+		update_rhall_terms(raw->raw_data_r, terms);
+
+	if (raw->raw_datax != BMM150_XYAXES_FLIP_OVERFLOW_ADCVAL && terms->xy_valid)
+		out->x = ((int16_t)((((int32_t)raw->raw_datax) * terms->kx) / 8192)) + comp_consts.x1_8;
+	else
+		out->x = BMM150_OVERFLOW_OUTPUT_Q4;
+
+	if (raw->raw_datay != BMM150_XYAXES_FLIP_OVERFLOW_ADCVAL && terms->xy_valid)
+		out->y = ((int16_t)((((int32_t)raw->raw_datay) * terms->ky) / 8192)) + comp_consts.y1_8;
+	else
+		out->y = BMM150_OVERFLOW_OUTPUT_Q4;
+
+	if (raw->raw_dataz != BMM150_ZAXIS_HALL_OVERFLOW_ADCVAL && terms->z_div != 0) {
+		int32_t retval = ((((int32_t)(raw->raw_dataz - trim_data.dig_z4)) * 32768) - terms->z_offset) / terms->z_div;
+
+		/* saturate result to +/- 2 micro-tesla */
+		if (retval > BMM150_POSITIVE_SATURATION_Z)
+			retval = BMM150_POSITIVE_SATURATION_Z;
+		else if (retval < BMM150_NEGATIVE_SATURATION_Z)
+			retval = BMM150_NEGATIVE_SATURATION_Z;
+		out->z = retval;
+	} else {
+		out->z = BMM150_OVERFLOW_OUTPUT_Q4;
+	}
 }
 
 /*
@@ -81,6 +344,17 @@ void BMM150::read_mag_data()
  */
 int16_t BMM150::compensate_x(int16_t mag_data_x, uint16_t data_rhall)
 {
+	/* Conversion of LSB to micro-tesla*/
+	return q4_to_ut(compensate_x_q4(mag_data_x, data_rhall));
+}
+
+/*
+ * @brief This internal API is used to obtain the compensated
+ * magnetometer X axis data in 1/16 micro-tesla.
+ */
+int32_t BMM150::compensate_x_q4(int16_t mag_data_x, uint16_t data_rhall)
+{
+	int32_t q4;
 	int16_t retval;
 	uint16_t process_comp_x0 = 0;
 	int32_t process_comp_x1;
@@ -118,16 +392,16 @@ int16_t BMM150::compensate_x(int16_t mag_data_x, uint16_t data_rhall)
 			process_comp_x9 = ((process_comp_x7 * process_comp_x8) / 4096);
 			process_comp_x10 = ((int32_t)mag_data_x) * process_comp_x9;
 			retval = ((int16_t)(process_comp_x10 / 8192));
-			retval = (retval + (((int16_t)trim_data.dig_x1) * 8)) / 16;
+			q4 = retval + (((int16_t)trim_data.dig_x1) * 8);
 		} else {
-			retval = BMM150_OVERFLOW_OUTPUT;
+			q4 = BMM150_OVERFLOW_OUTPUT_Q4;
 		}
 	} else {
 		/* Overflow condition */
-		retval = BMM150_OVERFLOW_OUTPUT;
+		q4 = BMM150_OVERFLOW_OUTPUT_Q4;
 	}
 
-	return retval;
+	return q4;
 }
 
 /*
@@ -136,6 +410,17 @@ int16_t BMM150::compensate_x(int16_t mag_data_x, uint16_t data_rhall)
  */
 int16_t BMM150::compensate_y(int16_t mag_data_y, uint16_t data_rhall)
 {
+	/* Conversion of LSB to micro-tesla*/
+	return q4_to_ut(compensate_y_q4(mag_data_y, data_rhall));
+}
+
+/*
+ * @brief This internal API is used to obtain the compensated
+ * magnetometer Y axis data in 1/16 micro-tesla.
+ */
+int32_t BMM150::compensate_y_q4(int16_t mag_data_y, uint16_t data_rhall)
+{
+	int32_t q4;
 	int16_t retval;
 	uint16_t process_comp_y0 = 0;
 	int32_t process_comp_y1;
@@ -171,16 +456,16 @@ int16_t BMM150::compensate_y(int16_t mag_data_y, uint16_t data_rhall)
 			process_comp_y8 = (((process_comp_y6 + ((int32_t)0x100000)) * process_comp_y7) / 4096);
 			process_comp_y9 = (((int32_t)mag_data_y) * process_comp_y8);
 			retval = (int16_t)(process_comp_y9 / 8192);
-			retval = (retval + (((int16_t)trim_data.dig_y1) * 8)) / 16;
+			q4 = retval + (((int16_t)trim_data.dig_y1) * 8);
 		} else {
-			retval = BMM150_OVERFLOW_OUTPUT;
+			q4 = BMM150_OVERFLOW_OUTPUT_Q4;
 		}
 	} else {
 		/* Overflow condition*/
-		retval = BMM150_OVERFLOW_OUTPUT;
+		q4 = BMM150_OVERFLOW_OUTPUT_Q4;
 	}
 
-	return retval;
+	return q4;
 }
 
 /*
@@ -188,6 +473,16 @@ int16_t BMM150::compensate_y(int16_t mag_data_y, uint16_t data_rhall)
  * magnetometer Z axis data(micro-tesla) in int16_t.
  */
 int16_t BMM150::compensate_z(int16_t mag_data_z, uint16_t data_rhall)
+{
+	/* Conversion of LSB to micro-tesla*/
+	return q4_to_ut(compensate_z_q4(mag_data_z, data_rhall));
+}
+
+/*
+ * @brief This internal API is used to obtain the compensated
+ * magnetometer Z axis data in 1/16 micro-tesla.
+ */
+int32_t BMM150::compensate_z_q4(int16_t mag_data_z, uint16_t data_rhall)
 {
 	int32_t retval;
 	int16_t process_comp_z0;
@@ -214,18 +509,16 @@ int16_t BMM150::compensate_z(int16_t mag_data_z, uint16_t data_rhall)
 				if (retval < BMM150_NEGATIVE_SATURATION_Z)
 					retval = BMM150_NEGATIVE_SATURATION_Z;
 			}
-			/* Conversion of LSB to micro-tesla*/
-			retval = retval / 16;
 		} else {
-			retval = BMM150_OVERFLOW_OUTPUT;
+			retval = BMM150_OVERFLOW_OUTPUT_Q4;
 
 		}
 	} else {
 		/* Overflow condition*/
-		retval = BMM150_OVERFLOW_OUTPUT;
+		retval = BMM150_OVERFLOW_OUTPUT_Q4;
 	}
 
-	return (int16_t)retval;
+	return retval;
 }
 
 void BMM150::set_presetmode(uint8_t preset_mode)
@@ -317,66 +610,25 @@ void BMM150::set_odr(struct bmm150_settings settings)
 
 void BMM150::i2c_write(short address, short data)
 {
-    Wire.beginTransmission(BMM150_I2C_Address);
-    Wire.write(address);
-    Wire.write(data);
-    Wire.endTransmission();
+    i2c_dev.writeReg(address, data);
 }
 
 void BMM150::i2c_read(short address, uint8_t *buffer, short length)
 {
-    Wire.beginTransmission(BMM150_I2C_Address);
-    Wire.write(address);
-    Wire.endTransmission();
-
-    Wire.beginTransmission(BMM150_I2C_Address);
-    Wire.requestFrom(BMM150_I2C_Address, length);
-    
-    if(Wire.available() == length)
-    {
-        for(uint8_t i = 0; i < length; i++)
-        {
-            buffer[i] = Wire.read();
-        }
-    }
-    
-    Wire.endTransmission();
+    i2c_dev.readRegs(address, buffer, length);
 }
 
 
 void BMM150::i2c_read(short address, int8_t *buffer, short length)
 {
-    Wire.beginTransmission(BMM150_I2C_Address);
-    Wire.write(address);
-    Wire.endTransmission();
-
-    Wire.beginTransmission(BMM150_I2C_Address);
-    Wire.requestFrom(BMM150_I2C_Address, length);
-    
-    if(Wire.available() == length)
-    {
-        for(uint8_t i = 0; i < length; i++)
-        {
-            buffer[i] = Wire.read();
-        }
-    }
-    
-    Wire.endTransmission();
+    i2c_dev.readRegs(address, (uint8_t *)buffer, length);
 }
 
 uint8_t BMM150::i2c_read(short address)
 {
-    uint8_t byte;
-
-    Wire.beginTransmission(BMM150_I2C_Address);
-    Wire.write(address);
-    Wire.endTransmission();
+    uint8_t byte = 0;
 
-    Wire.beginTransmission(BMM150_I2C_Address);
-    Wire.requestFrom(BMM150_I2C_Address, 1);
-    byte = Wire.read();
-    
-    Wire.endTransmission();
+    i2c_dev.readReg(address, &byte);
     return byte;
 }
 
@@ -461,6 +713,7 @@ void BMM150::read_trim_registers()
 	temp_msb = ((uint16_t)(trim_xy1xy2[5] & 0x7F)) << 8;
 	trim_data.dig_xyz1 = (uint16_t)(temp_msb | trim_xy1xy2[4]);
 
+	update_comp_consts();
 }
 
 void BMM150::write_op_mode(uint8_t op_mode)
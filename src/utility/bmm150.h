@@ -6,6 +6,8 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include "bmm150_defs.h"
+#include "I2CBus.h"
+#include "SampleRing.h"
 
 class BMM150{
 
@@ -13,15 +15,52 @@ public:
   BMM150();
   /**
    * \brief initialze device 
-   * 
+   * \param preset_mode BMM150_PRESETMODE_LOWPOWER..BMM150_PRESETMODE_ENHANCED
+   * \param op_mode BMM150_NORMAL_MODE to run at the preset ODR, or
+   * BMM150_FORCED_MODE to stay asleep until read_mag_data_forced()
   */
-  int8_t initialize(void);
+  int8_t initialize(uint8_t preset_mode = BMM150_PRESETMODE_LOWPOWER, uint8_t op_mode = BMM150_NORMAL_MODE);
+
+  /**
+   * \brief Move the sensor to another bus or SCL frequency, call before initialize()
+   * \param clock SCL frequency in Hz, 0 for the bus default
+  */
+  void set_bus(I2CBus &bus, uint32_t clock = 0) { i2c_dev.setBus(bus); i2c_dev.setClock(clock); }
   
   /**
    * \brief Read magnetometer data
   */
   void read_mag_data();
 
+  /**
+   * @brief Trigger one forced-mode conversion, sleep for its conversion
+   * time, wait for DRDY and read the result into raw_mag_data/mag_data.
+   * The sensor goes back to sleep by itself afterwards.
+   * \return BMM150_OK or BMM150_E_TIMEOUT
+  */
+  int8_t read_mag_data_forced();
+
+  /**
+   * @brief Forced-mode conversion time for the current repetition settings
+  */
+  uint32_t get_conversion_time_us();
+
+  /**
+   * @brief Route DRDY to the DRDY pin (active high)
+  */
+  void set_drdy_interrupt(bool enable);
+
+  /**
+   * @brief DRDY-driven streaming in normal mode at the preset ODR:
+   * DRDY edge -> reader task -> sample ring. Returns BMM150_OK or BMM150_E_STREAM.
+  */
+  int8_t start_stream(uint8_t drdy_pin, UBaseType_t priority = 5, BaseType_t core = tskNO_AFFINITY);
+  void stop_stream();
+  void set_stream_consumer(TaskHandle_t task) { stream_consumer = task; }
+  bool read_sample(struct bmm150_sample *sample) { return ring.pop(sample); }
+  uint32_t available_samples() { return ring.available(); }
+  uint32_t get_stream_overruns() { return ring.getOverruns(); }
+
   /**
    * @brief This internal API is used to obtain the compensated
    * magnetometer x axis data(micro-tesla) in float.
@@ -40,6 +79,44 @@ public:
   */
   int16_t compensate_z(int16_t mag_data_z, uint16_t data_rhall);
 
+  /**
+   * @brief Same compensation as compensate_x/y/z, but keeps the four
+   * fractional bits the int16_t micro-tesla output drops (1/16 uT per LSB).
+   * Returns BMM150_OVERFLOW_OUTPUT_Q4 on overflow.
+  */
+  int32_t compensate_x_q4(int16_t mag_data_x, uint16_t data_rhall);
+  int32_t compensate_y_q4(int16_t mag_data_y, uint16_t data_rhall);
+  int32_t compensate_z_q4(int16_t mag_data_z, uint16_t data_rhall);
+
+  /**
+   * @brief Compensate a block of raw samples in one pass. Results are
+   * identical to compensate_x/y/z, but the trim-derived constants are
+   * computed once in read_trim_registers() and the hall resistance terms
+   * (including the divisions) are reused within the block while rhall does
+   * not change.
+  */
+  void compensate_block(const struct bmm150_raw_mag_data *raw, struct bmm150_mag_data *out, uint16_t count);
+  void compensate_block_q4(const struct bmm150_raw_mag_data *raw, struct bmm150_mag_data_q4 *out, uint16_t count);
+
+  /**
+   * @brief Recompute the block compensation constants from trim_data.
+   * Called by read_trim_registers(); only needed if trim_data is changed by hand.
+  */
+  void update_comp_consts();
+
+  /**
+   * @brief Read one raw sample without compensating it
+  */
+  void read_raw_mag_data(struct bmm150_raw_mag_data *raw);
+
+  /**
+   * @brief Convert a Q4 value to micro-tesla the way compensate_x/y/z round it
+  */
+  static int16_t q4_to_ut(int32_t q4)
+  {
+    return q4 == BMM150_OVERFLOW_OUTPUT_Q4 ? BMM150_OVERFLOW_OUTPUT : (int16_t)(q4 / 16);
+  }
+
   /**
    * \brief Set power mode
   */
@@ -131,9 +208,26 @@ public:
     struct bmm150_settings settings;
     struct bmm150_raw_mag_data raw_mag_data;
     struct bmm150_mag_data mag_data;
+    struct bmm150_mag_data_q4 mag_data_q4;
     struct bmm150_trim_registers trim_data;
+    struct bmm150_comp_consts comp_consts;
+
+
+    void update_rhall_terms(uint16_t data_rhall, struct bmm150_rhall_terms *terms);
+    void compensate_q4(const struct bmm150_raw_mag_data *raw, struct bmm150_mag_data_q4 *out,
+                       struct bmm150_rhall_terms *terms);
+
+    static void on_drdy(void *arg);
+    static void stream_loop(void *arg);
 
+    volatile bool streaming;
+    uint8_t stream_pin;
+    TaskHandle_t stream_task;
+    TaskHandle_t stream_consumer;
+    volatile uint32_t irq_timestamp;
+    SampleRing<struct bmm150_sample, BMM150_STREAM_DEPTH> ring;
 
+    I2CDevice i2c_dev;
     void i2c_write(short address, short byte);
     void i2c_read(short address, uint8_t *buffer, short length);
     void i2c_read(short address, int8_t *buffer, short length);
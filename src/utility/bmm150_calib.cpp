@@ -0,0 +1,330 @@
+#include "bmm150_calib.h"
+
+/* Samples are scaled down before they are accumulated to keep D'D well conditioned */
+#define BMM150_CALIB_SCALE      (0.01)
+
+/*
+ * @brief Index of (i, j), i <= j, in a packed upper triangle of a 9x9 matrix
+ */
+static inline uint8_t tri_index(uint8_t i, uint8_t j)
+{
+	return i * 9 - (i * (i - 1)) / 2 + (j - i);
+}
+
+/*
+ * @brief Solve a * x = b by Gaussian elimination with partial pivoting.
+ * a is n x n row major and is destroyed, b is replaced by x.
+ */
+static bool gauss_solve(double *a, double *b, uint8_t n)
+{
+	for (uint8_t col = 0; col < n; col++) {
+		uint8_t pivot = col;
+		for (uint8_t row = col + 1; row < n; row++) {
+			if (fabs(a[row * n + col]) > fabs(a[pivot * n + col]))
+				pivot = row;
+		}
+		if (fabs(a[pivot * n + col]) < 1e-12)
+			return false;
+
+		if (pivot != col) {
+			for (uint8_t k = 0; k < n; k++) {
+				double t = a[col * n + k];
+				a[col * n + k] = a[pivot * n + k];
+				a[pivot * n + k] = t;
+			}
+			double t = b[col];
+			b[col] = b[pivot];
+			b[pivot] = t;
+		}
+
+		for (uint8_t row = col + 1; row < n; row++) {
+			double f = a[row * n + col] / a[col * n + col];
+			for (uint8_t k = col; k < n; k++)
+				a[row * n + k] -= f * a[col * n + k];
+			b[row] -= f * b[col];
+		}
+	}
+
+	for (int8_t row = n - 1; row >= 0; row--) {
+		double sum = b[row];
+		for (uint8_t k = row + 1; k < n; k++)
+			sum -= a[row * n + k] * b[k];
+		b[row] = sum / a[row * n + row];
+	}
+	return true;
+}
+
+/*
+ * @brief Eigen decomposition of a symmetric 3x3 matrix by cyclic Jacobi
+ * rotations. a is destroyed, its diagonal ends up holding the eigenvalues;
+ * the columns of v are the eigenvectors.
+ */
+static void jacobi_eigen3(double a[3][3], double v[3][3])
+{
+	for (uint8_t i = 0; i < 3; i++)
+		for (uint8_t j = 0; j < 3; j++)
+			v[i][j] = (i == j) ? 1.0 : 0.0;
+
+	for (uint8_t sweep = 0; sweep < 50; sweep++) {
+		double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+		if (off < 1e-15)
+			break;
+
+		for (uint8_t p = 0; p < 2; p++) {
+			for (uint8_t q = p + 1; q < 3; q++) {
+				if (a[p][q] == 0.0)
+					continue;
+
+				double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0);
+				double s = t * c;
+
+				for (uint8_t k = 0; k < 3; k++) {
+					double akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (uint8_t k = 0; k < 3; k++) {
+					double apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (uint8_t k = 0; k < 3; k++) {
+					double vkp = v[k][p], vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+}
+
+/*
+ * @brief CRC-32 (IEEE 802.3, reflected)
+ */
+static uint32_t calib_crc32(const uint8_t *data, size_t len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	while (len--) {
+		crc ^= *data++;
+		for (uint8_t k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
+BMM150Calibration::BMM150Calibration()
+{
+	calibrated = false;
+	fit_error = 0.0f;
+	memset(&calib, 0, sizeof(calib));
+	calib.matrix[0] = calib.matrix[4] = calib.matrix[8] = 1.0f;
+	reset();
+}
+
+void BMM150Calibration::reset()
+{
+	memset(dtd, 0, sizeof(dtd));
+	memset(dtd2, 0, sizeof(dtd2));
+	d2d2 = 0.0;
+	samples = 0;
+}
+
+/*
+ * @brief Accumulate one sample in micro-tesla into the normal equations
+ */
+void BMM150Calibration::add_sample(float x, float y, float z)
+{
+	double sx = x * BMM150_CALIB_SCALE;
+	double sy = y * BMM150_CALIB_SCALE;
+	double sz = z * BMM150_CALIB_SCALE;
+	double d2 = sx * sx + sy * sy + sz * sz;
+	double d[9] = {
+		sx * sx + sy * sy - 2.0 * sz * sz,
+		sx * sx + sz * sz - 2.0 * sy * sy,
+		2.0 * sx * sy, 2.0 * sx * sz, 2.0 * sy * sz,
+		2.0 * sx, 2.0 * sy, 2.0 * sz,
+		1.0
+	};
+
+	for (uint8_t i = 0; i < 9; i++) {
+		for (uint8_t j = i; j < 9; j++)
+			dtd[tri_index(i, j)] += d[i] * d[j];
+		dtd2[i] += d[i] * d2;
+	}
+	d2d2 += d2 * d2;
+	samples++;
+}
+
+void BMM150Calibration::add_sample(const struct bmm150_mag_data *mag)
+{
+	if (mag->x == BMM150_OVERFLOW_OUTPUT || mag->y == BMM150_OVERFLOW_OUTPUT || mag->z == BMM150_OVERFLOW_OUTPUT)
+		return;
+	add_sample(mag->x, mag->y, mag->z);
+}
+
+void BMM150Calibration::add_sample(const struct bmm150_mag_data_q4 *mag)
+{
+	if (mag->x == BMM150_OVERFLOW_OUTPUT_Q4 || mag->y == BMM150_OVERFLOW_OUTPUT_Q4 || mag->z == BMM150_OVERFLOW_OUTPUT_Q4)
+		return;
+	add_sample(mag->x / 16.0f, mag->y / 16.0f, mag->z / 16.0f);
+}
+
+/*
+ * @brief Fit the quadric x'Ax + 2b'x + c = 0 and turn it into
+ * offset = -A^-1 b and matrix = M^1/2 * field, where M is A normalized to
+ * (x - offset)'M(x - offset) = 1.
+ *
+ * The fit regresses |x|^2 on [x2+y2-2z2, x2+z2-2y2, 2xy, 2xz, 2yz, 2x, 2y, 2z, 1],
+ * which fixes trace(A) instead of the constant term. Unlike x'Ax + 2b'x = 1
+ * this stays well conditioned when the hard-iron offset is as large as the
+ * field itself.
+ */
+bool BMM150Calibration::solve()
+{
+	double a[81];
+	double v[9];
+
+	if (samples < BMM150_CALIB_MIN_SAMPLES)
+		return false;
+
+	for (uint8_t i = 0; i < 9; i++) {
+		for (uint8_t j = i; j < 9; j++)
+			a[i * 9 + j] = a[j * 9 + i] = dtd[tri_index(i, j)];
+		v[i] = dtd2[i];
+	}
+	if (!gauss_solve(a, v, 9))
+		return false;
+
+	/* Ellipsoid matrix and center */
+	double A[9] = {
+		v[0] + v[1] - 1.0, v[2], v[3],
+		v[2], v[0] - 2.0 * v[1] - 1.0, v[4],
+		v[3], v[4], v[1] - 2.0 * v[0] - 1.0
+	};
+	double center[3] = { -v[5], -v[6], -v[7] };
+	double tmp[9];
+	memcpy(tmp, A, sizeof(tmp));
+	if (!gauss_solve(tmp, center, 3))
+		return false;
+
+	double k = -v[8];
+	for (uint8_t i = 0; i < 3; i++)
+		for (uint8_t j = 0; j < 3; j++)
+			k += center[i] * A[i * 3 + j] * center[j];
+	if (k == 0.0)
+		return false;
+
+	double m[3][3], vec[3][3];
+	for (uint8_t i = 0; i < 3; i++)
+		for (uint8_t j = 0; j < 3; j++)
+			m[i][j] = A[i * 3 + j] / k;
+	jacobi_eigen3(m, vec);
+
+	double lambda[3] = { m[0][0], m[1][1], m[2][2] };
+	if (lambda[0] <= 0.0 || lambda[1] <= 0.0 || lambda[2] <= 0.0)
+		return false;
+
+	/* Field strength: geometric mean of the radii */
+	double field = cbrt(1.0 / sqrt(lambda[0] * lambda[1] * lambda[2]));
+
+	for (uint8_t i = 0; i < 3; i++) {
+		for (uint8_t j = 0; j < 3; j++) {
+			double w = 0.0;
+			for (uint8_t n = 0; n < 3; n++)
+				w += vec[i][n] * sqrt(lambda[n]) * field * vec[j][n];
+			calib.matrix[i * 3 + j] = (float)w;
+		}
+		calib.offset[i] = (float)(center[i] / BMM150_CALIB_SCALE);
+	}
+	calib.field = (float)(field / BMM150_CALIB_SCALE);
+
+	/* |Dv - d2|^2 = v'D'Dv - 2v'D'd2 + d2'd2, reported relative to field^2 */
+	double err = d2d2;
+	for (uint8_t i = 0; i < 9; i++) {
+		err -= 2.0 * v[i] * dtd2[i];
+		for (uint8_t j = 0; j < 9; j++)
+			err += v[i] * dtd[i <= j ? tri_index(i, j) : tri_index(j, i)] * v[j];
+	}
+	fit_error = (float)(sqrt((err > 0.0 ? err : 0.0) / samples) / (field * field));
+
+	calibrated = true;
+	return true;
+}
+
+void BMM150Calibration::set_calibration(const struct bmm150_calib_data &data)
+{
+	calib = data;
+	calibrated = true;
+}
+
+void BMM150Calibration::correct(float x, float y, float z, float out[3])
+{
+	float d[3] = { x - calib.offset[0], y - calib.offset[1], z - calib.offset[2] };
+
+	for (uint8_t i = 0; i < 3; i++)
+		out[i] = calib.matrix[i * 3] * d[0] + calib.matrix[i * 3 + 1] * d[1] + calib.matrix[i * 3 + 2] * d[2];
+}
+
+void BMM150Calibration::correct(const struct bmm150_mag_data *mag, float out[3])
+{
+	correct(mag->x, mag->y, mag->z, out);
+}
+
+void BMM150Calibration::correct(const struct bmm150_mag_data_q4 *mag, float out[3])
+{
+	correct(mag->x / 16.0f, mag->y / 16.0f, mag->z / 16.0f, out);
+}
+
+void BMM150Calibration::to_blob(struct bmm150_calib_blob *blob)
+{
+	blob->magic = BMM150_CALIB_MAGIC;
+	blob->version = BMM150_CALIB_VERSION;
+	blob->size = sizeof(struct bmm150_calib_blob);
+	blob->data = calib;
+	blob->crc = calib_crc32((const uint8_t *)blob, offsetof(struct bmm150_calib_blob, crc));
+}
+
+bool BMM150Calibration::from_blob(const struct bmm150_calib_blob *blob)
+{
+	if (blob->magic != BMM150_CALIB_MAGIC || blob->version != BMM150_CALIB_VERSION
+	|| blob->size != sizeof(struct bmm150_calib_blob))
+		return false;
+	if (blob->crc != calib_crc32((const uint8_t *)blob, offsetof(struct bmm150_calib_blob, crc)))
+		return false;
+
+	set_calibration(blob->data);
+	return true;
+}
+
+bool BMM150Calibration::save(fs::FS &fs, const char *path)
+{
+	struct bmm150_calib_blob blob;
+
+	if (!calibrated)
+		return false;
+
+	to_blob(&blob);
+	fs::File file = fs.open(path, FILE_WRITE);
+	if (!file)
+		return false;
+	size_t written = file.write((const uint8_t *)&blob, sizeof(blob));
+	file.close();
+	return written == sizeof(blob);
+}
+
+bool BMM150Calibration::load(fs::FS &fs, const char *path)
+{
+	struct bmm150_calib_blob blob;
+
+	fs::File file = fs.open(path, FILE_READ);
+	if (!file)
+		return false;
+	size_t got = file.read((uint8_t *)&blob, sizeof(blob));
+	file.close();
+	if (got != sizeof(blob))
+		return false;
+	return from_blob(&blob);
+}
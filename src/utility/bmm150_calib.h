@@ -0,0 +1,110 @@
+#ifndef _BMM150_CALIB_H_
+#define _BMM150_CALIB_H_
+
+#include <Arduino.h>
+#include <FS.h>
+#include "bmm150.h"
+
+#define BMM150_CALIB_MAGIC          (0x434D4D42)    /* "BMMC" */
+#define BMM150_CALIB_VERSION        (1)
+#define BMM150_CALIB_MIN_SAMPLES    (50)
+#define BMM150_CALIB_PATH           "/bmm150.cal"
+
+/*
+ * @brief Hard/soft-iron correction: corrected = matrix * (raw - offset)
+ */
+struct bmm150_calib_data {
+	/*! Hard-iron offset in micro-tesla */
+	float offset[3];
+	/*! Soft-iron correction, row major */
+	float matrix[9];
+	/*! Local field strength in micro-tesla */
+	float field;
+};
+
+/*
+ * @brief On-flash layout of a calibration, little endian
+ */
+struct __attribute__ ((packed)) bmm150_calib_blob {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t size;
+	struct bmm150_calib_data data;
+	uint32_t crc;
+};
+
+/*
+ * Online ellipsoid fit for BMM150 hard- and soft-iron calibration.
+ *
+ * Every sample only updates the normal equations of a 9 parameter
+ * ellipsoid fit, so memory stays constant no matter how many
+ * samples are fed. solve() can be called at any time, e.g. once a second
+ * while the user turns the device, and the result refines as coverage
+ * improves.
+ */
+class BMM150Calibration {
+
+public:
+  BMM150Calibration();
+
+  /**
+   * \brief Drop all accumulated samples, the current solution is kept
+  */
+  void reset();
+
+  /**
+   * \brief Accumulate one sample
+  */
+  void add_sample(float x, float y, float z);
+  void add_sample(const struct bmm150_mag_data *mag);
+  void add_sample(const struct bmm150_mag_data_q4 *mag);
+
+  uint32_t get_sample_count() { return samples; }
+
+  /**
+   * \brief Fit the ellipsoid to the samples so far
+   * \return true if the fit is a valid ellipsoid and was taken as the new calibration
+  */
+  bool solve();
+
+  /**
+   * \brief RMS fit residual of the last successful fit relative to field^2, lower is better
+  */
+  float get_fit_error() { return fit_error; }
+
+  bool is_calibrated() { return calibrated; }
+  const struct bmm150_calib_data &get_calibration() { return calib; }
+  void set_calibration(const struct bmm150_calib_data &data);
+
+  /**
+   * \brief Apply the calibration, result in micro-tesla
+  */
+  void correct(float x, float y, float z, float out[3]);
+  void correct(const struct bmm150_mag_data *mag, float out[3]);
+  void correct(const struct bmm150_mag_data_q4 *mag, float out[3]);
+
+  /**
+   * \brief Serialize to / restore from a blob with magic, version and CRC
+  */
+  void to_blob(struct bmm150_calib_blob *blob);
+  bool from_blob(const struct bmm150_calib_blob *blob);
+
+  /**
+   * \brief Store / load the blob on SPIFFS, SD or any other FS
+  */
+  bool save(fs::FS &fs, const char *path = BMM150_CALIB_PATH);
+  bool load(fs::FS &fs, const char *path = BMM150_CALIB_PATH);
+
+private:
+  /* Upper triangle of D'D, D'd2 and d2'd2, see solve() */
+  double dtd[45];
+  double dtd2[9];
+  double d2d2;
+  uint32_t samples;
+
+  struct bmm150_calib_data calib;
+  bool calibrated;
+  float fit_error;
+};
+
+#endif
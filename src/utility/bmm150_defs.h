@@ -13,6 +13,8 @@
 #define BMM150_E_ID_NOT_CONFORM		    (-1)
 #define BMM150_E_INVALID_CONFIG         (-2)
 // #define BMM150_E_ID_WRONG		    (-3)
+#define BMM150_E_TIMEOUT                (-4)
+#define BMM150_E_STREAM                 (-5)
 
 /**\name API warning codes */
 #define BMM150_W_NORMAL_SELF_TEST_YZ_FAIL	INT8_C(1)
@@ -52,6 +54,17 @@
 #define BMM150_START_UP_TIME		(3)
 #define BMM150_ADV_SELF_TEST_DELAY	(4)
 
+/**\name Forced mode conversion time: 145us * nXY + 500us * nZ + 980us,
+ * nXY = 1 + 2 * REP_XY, nZ = 1 + REP_Z */
+#define BMM150_CONV_TIME_XY_US		(145)
+#define BMM150_CONV_TIME_Z_US		(500)
+#define BMM150_CONV_TIME_BASE_US	(980)
+/*! Extra time allowed for DRDY after the nominal conversion time */
+#define BMM150_DRDY_TIMEOUT_US		(2000)
+
+/**\name DRDY streaming */
+#define BMM150_STREAM_DEPTH		(32)
+
 /**\name ENABLE/DISABLE DEFINITIONS  */
 #define BMM150_XY_CHANNEL_ENABLE	0x00
 #define BMM150_XY_CHANNEL_DISABLE	0x03
@@ -181,6 +194,7 @@
 #define BMM150_OVERFLOW_OUTPUT			        (-32768)
 #define BMM150_NEGATIVE_SATURATION_Z        (-32767)
 #define BMM150_POSITIVE_SATURATION_Z        (32767)
+#define BMM150_OVERFLOW_OUTPUT_Q4           INT32_MIN
 #ifdef BMM150_USE_FLOATING_POINT
 #define BMM150_OVERFLOW_OUTPUT_FLOAT		0.0f
 #endif
@@ -229,6 +243,17 @@ struct bmm150_mag_data
     int16_t z;
 };
 
+/*
+ * @brief bmm150 compensated magnetometer data in 1/16 micro-tesla (Q4),
+ * i.e. before the final LSB to micro-tesla division
+ */
+struct bmm150_mag_data_q4
+{
+    int32_t x;
+    int32_t y;
+    int32_t z;
+};
+
 /*
  * @brief bmm150 un-compensated (raw) magnetometer data
  */
@@ -271,6 +296,55 @@ struct bmm150_trim_registers {
 	uint16_t dig_xyz1;
 };
 
+/*!
+ * @brief bmm150 compensation constants derived once from the trim data
+ */
+struct bmm150_comp_consts {
+	/*! dig_xyz1 * 16384 */
+	int32_t xyz1_16384;
+	/*! dig_xy1 * 128 */
+	int32_t xy1_128;
+	/*! dig_xy2 */
+	int32_t xy2;
+	/*! dig_x2 + 0xA0 */
+	int32_t x2_a0;
+	/*! dig_y2 + 0xA0 */
+	int32_t y2_a0;
+	/*! dig_x1 * 8 */
+	int32_t x1_8;
+	/*! dig_y1 * 8 */
+	int32_t y1_8;
+	/*! Z compensation is possible with this trim set */
+	uint8_t z_valid;
+};
+
+/*!
+ * @brief bmm150 compensation terms that only depend on the hall resistance,
+ * owned by each caller so concurrent compensations never share them
+ */
+struct bmm150_rhall_terms {
+	/*! Hall resistance the terms below belong to */
+	uint16_t rhall;
+	/*! Terms are valid */
+	uint8_t rhall_valid;
+	/*! X/Y can be compensated for this rhall */
+	uint8_t xy_valid;
+	/*! X/Y gain for this rhall */
+	int32_t kx;
+	int32_t ky;
+	/*! Z offset and divisor for this rhall */
+	int32_t z_offset;
+	int32_t z_div;
+};
+
+/*!
+ * @brief bmm150 compensated sample with the micros() time of its DRDY edge
+ */
+struct bmm150_sample {
+	uint32_t timestamp;
+	struct bmm150_mag_data_q4 mag;
+};
+
 /**
  * @brief bmm150 sensor settings
  */
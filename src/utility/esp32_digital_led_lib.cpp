@@ -63,6 +63,8 @@ extern "C" {
 }
 #endif
 
+#include <math.h>
+
 #define COUNT_OF(x) ((sizeof(x)/sizeof(0[x])) / ((size_t)(!(sizeof(x) % sizeof(0[x])))))
 
 #if DEBUG_ESP32_DIGITAL_LED_LIB
@@ -71,6 +73,7 @@ extern int digitalLeds_debugBufferSz;
 #endif
 
 static DRAM_ATTR const uint16_t MAX_PULSES = 32;  // A channel has a 64 "pulse" buffer - we use half per pass
+static DRAM_ATTR const uint16_t MAX_MEM_BLOCKS = 7;  // Keeps the tx threshold (half the pulses) below 256, which some IDF releases reject
 static DRAM_ATTR const uint16_t DIVIDER    =  4;  // 8 still seems to work, but timings become marginal
 static DRAM_ATTR const double   RMT_DURATION_NS = 12.5;  // Minimum time of a single RMT duration based on clock ns
 
@@ -117,7 +120,14 @@ typedef union {
 typedef struct {
   uint8_t * buf_data;
   uint16_t buf_pos, buf_len, buf_half, buf_isDirty;
+  uint16_t half_pulses;  // MAX_PULSES times the strand's RMT memory blocks
   rmtPulsePair pulsePairMap[2];
+  rmtPulsePair nibblePulseMap[16][4];  // pulsePairMap expanded for every 4 bit value, MSB first
+  uint16_t colorLut[256];  // Brightness and gamma corrected output per input value, 8.8 fixed point
+  int lut_bright;          // brightLimit colorLut was built for
+  float gamma;
+  bool dither;
+  uint8_t dither_frame;
   bool isProcessing;
 } digitalLeds_stateData;
 
@@ -125,6 +135,7 @@ const static int MAX_RMT_CHANNELS = 8;
 static strand_t * strandDataPtrs[MAX_RMT_CHANNELS] = {nullptr};  // Indexed by RMT channel
 
 // Forward declarations of local functions
+static void buildColorLut(strand_t * pStrand);
 static void copyHalfBlockToRmt(strand_t * pStrand);
 static void rmtInterruptHandler(void *arg);
 
@@ -133,6 +144,8 @@ static xSemaphoreHandle gRmtSem = nullptr;
 static intr_handle_t gRmtIntrHandle = nullptr;
 
 static int gToProcess = 0;
+static digitalLeds_drawDoneCb_t gDrawDoneCb = nullptr;
+static void * gDrawDoneArg = nullptr;
 
 
 int digitalLeds_initDriver()
@@ -159,13 +172,36 @@ int digitalLeds_addStrands(strand_t * strands [], int numStrands)
   for (int i = 0; i < numStrands; i++) {
     int rmtChannel = strands[i]->rmtChannel;
     strand_t * pStrand = strands[i];
+
+    // The memory blocks must not overlap those of another strand
+    int memBlocks = (pStrand->rmtMemBlocks > 0) ? pStrand->rmtMemBlocks : 1;
+    if (memBlocks > MAX_MEM_BLOCKS || rmtChannel + memBlocks > MAX_RMT_CHANNELS) {
+      return -4;
+    }
+    for (int ch = 0; ch < MAX_RMT_CHANNELS; ch++) {
+      strand_t * pOther = strandDataPtrs[ch];
+      if (pOther == nullptr || pOther == pStrand) {
+        continue;
+      }
+      int otherBlocks = (pOther->rmtMemBlocks > 0) ? pOther->rmtMemBlocks : 1;
+      if (ch < rmtChannel + memBlocks && rmtChannel < ch + otherBlocks) {
+        return -4;
+      }
+    }
+
     strandDataPtrs[rmtChannel] = pStrand;
 
     ledParams_t ledParams = ledParamsAll[pStrand->ledType];
 
-    pStrand->pixels = static_cast<pixelColor_t*>(malloc(pStrand->numPixels * sizeof(pixelColor_t)));
-    if (pStrand->pixels == nullptr) {
-      return -1;
+    // A native order strand is rendered into the transmit buffer itself
+    if (pStrand->nativeOrder) {
+      pStrand->pixels = nullptr;
+    }
+    else {
+      pStrand->pixels = static_cast<pixelColor_t*>(malloc(pStrand->numPixels * sizeof(pixelColor_t)));
+      if (pStrand->pixels == nullptr) {
+        return -1;
+      }
     }
 
     pStrand->_stateVars = static_cast<digitalLeds_stateData*>(malloc(sizeof(digitalLeds_stateData)));
@@ -175,17 +211,19 @@ int digitalLeds_addStrands(strand_t * strands [], int numStrands)
     digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
 
     pState->buf_len = (pStrand->numPixels * ledParams.bytesPerPixel);
+    pState->half_pulses = MAX_PULSES * memBlocks;
     pState->buf_data = static_cast<uint8_t*>(malloc(pState->buf_len));
     if (pState->buf_data == nullptr) {
       return -3;
     }
+    pStrand->wireBytes = pStrand->nativeOrder ? pState->buf_data : nullptr;
 
     // RMT configuration for transmission
     rmt_config_t rmt_tx;
     rmt_tx.channel = static_cast<rmt_channel_t>(rmtChannel);
     rmt_tx.gpio_num = static_cast<gpio_num_t>(pStrand->gpioNum);
     rmt_tx.rmt_mode = RMT_MODE_TX;
-    rmt_tx.mem_block_num = 1;
+    rmt_tx.mem_block_num = memBlocks;
     rmt_tx.clk_div = DIVIDER;
     rmt_tx.tx_config.loop_en = false;
     rmt_tx.tx_config.carrier_level = RMT_CARRIER_LEVEL_LOW;
@@ -206,10 +244,26 @@ int digitalLeds_addStrands(strand_t * strands [], int numStrands)
     pState->pulsePairMap[1].duration0 = ledParams.T1H / (RMT_DURATION_NS * DIVIDER);
     pState->pulsePairMap[1].duration1 = ledParams.T1L / (RMT_DURATION_NS * DIVIDER);
 
+    pState->gamma = 1.0f;
+    pState->dither = false;
+    pState->dither_frame = 0;
+    buildColorLut(pStrand);
+
+    for (int nibble = 0; nibble < 16; nibble++) {
+      for (int bit = 0; bit < 4; bit++) {
+        pState->nibblePulseMap[nibble][bit] = pState->pulsePairMap[(nibble >> (3 - bit)) & 0x01];
+      }
+    }
+
     pState->isProcessing = false;
 
     // Set interrupts
-    rmt_set_tx_thr_intr_en(static_cast<rmt_channel_t>(rmtChannel), true, MAX_PULSES);  // sets rmt_set_tx_wrap_en and RMT.tx_lim_ch<n>.limit
+    // Fires after every half of the channel's memory, however many blocks that spans
+    // Without it there are no refill interrupts and the strand would be sent garbled
+    if (rmt_set_tx_thr_intr_en(static_cast<rmt_channel_t>(rmtChannel), true, pState->half_pulses) != ESP_OK) {  // sets rmt_set_tx_wrap_en and RMT.tx_lim_ch<n>.limit
+      strandDataPtrs[rmtChannel] = nullptr;
+      return -5;
+    }
   }
 
   digitalLeds_resetPixels(strands, numStrands);
@@ -242,7 +296,13 @@ int digitalLeds_resetPixels(strand_t * strands [], int numStrands)
   for (int i = 0; i < numStrands; i++) {
     int rmtChannel = strands[i]->rmtChannel;
     strand_t * pStrand = strandDataPtrs[rmtChannel];
-    memset(pStrand->pixels, 0, pStrand->numPixels * sizeof(pixelColor_t));
+    if (pStrand->nativeOrder) {
+      digitalLeds_waitDrawn(UINT32_MAX);
+      memset(pStrand->wireBytes, 0, pStrand->numPixels * ledParamsAll[pStrand->ledType].bytesPerPixel);
+    }
+    else {
+      memset(pStrand->pixels, 0, pStrand->numPixels * sizeof(pixelColor_t));
+    }
   }
 
   digitalLeds_drawPixels(strands, numStrands);
@@ -252,6 +312,20 @@ int digitalLeds_resetPixels(strand_t * strands [], int numStrands)
 
 
 int IRAM_ATTR digitalLeds_drawPixels(strand_t * strands [], int numStrands)
+{
+  int rc = digitalLeds_drawPixelsAsync(strands, numStrands, nullptr, nullptr);
+  if (rc != 0) {
+    return rc;
+  }
+
+  digitalLeds_waitDrawn(UINT32_MAX);
+
+  return 0;
+}
+
+
+int IRAM_ATTR digitalLeds_drawPixelsAsync(strand_t * strands [], int numStrands,
+                                          digitalLeds_drawDoneCb_t onDone, void * arg)
 {
   // TODO: The input is strands for convenience - the point is to get indicies of strands to draw
   // Could just pass the channel numbers, but would it be slower to construct that list?
@@ -260,10 +334,25 @@ int IRAM_ATTR digitalLeds_drawPixels(strand_t * strands [], int numStrands)
     return 0;
   }
 
-  gToProcess = numStrands;
+  // Reject the frame before any strand of it is started
+  for (int i = 0; i < numStrands; i++) {
+    strand_t * pStrand = strandDataPtrs[strands[i]->rmtChannel];
+    int bytesPerPixel = ledParamsAll[pStrand->ledType].bytesPerPixel;
+    if (bytesPerPixel != 3 && bytesPerPixel != 4) {
+      return -1;
+    }
+    if (pStrand->brightLimit != static_cast<digitalLeds_stateData*>(pStrand->_stateVars)->lut_bright) {
+      buildColorLut(pStrand);
+    }
+  }
 
+  // Held from here until the interrupt handler has seen the last strand finish
   xSemaphoreTake(gRmtSem, portMAX_DELAY);
 
+  gToProcess = numStrands;
+  gDrawDoneCb = onDone;
+  gDrawDoneArg = arg;
+
   for (int i = 0; i < numStrands; i++) {
     int rmtChannel = strands[i]->rmtChannel;
     strand_t * pStrand = strandDataPtrs[rmtChannel];
@@ -273,22 +362,38 @@ int IRAM_ATTR digitalLeds_drawPixels(strand_t * strands [], int numStrands)
 
     pState->isProcessing = true;
 
+    // Correction is colorLut rounded to 8 bits, or truncated after adding
+    // this frame's dither offset (the frame count with its bits reversed).
+    // colorLut tops out at 255.0, so neither can carry past 8 bits.
+    const uint16_t * lut = pState->colorLut;
+    uint32_t bias = 0x80;
+    if (pState->dither) {
+      uint8_t f = pState->dither_frame++;
+      f = ((f & 0xF0) >> 4) | ((f & 0x0F) << 4);
+      f = ((f & 0xCC) >> 2) | ((f & 0x33) << 2);
+      f = ((f & 0xAA) >> 1) | ((f & 0x55) << 1);
+      bias = f;
+    }
+
     // Pack pixels into transmission buffer
-    if (ledParams.bytesPerPixel == 3) {
+    if (pStrand->nativeOrder) {
+      // Rendered in wire order by the application, sent in place
+    }
+    else if (ledParams.bytesPerPixel == 3) {
       for (uint16_t i = 0; i < pStrand->numPixels; i++) {
         // Color order is translated from RGB to GRB
-        pState->buf_data[0 + i * 3] = pStrand->pixels[i].g;
-        pState->buf_data[1 + i * 3] = pStrand->pixels[i].r;
-        pState->buf_data[2 + i * 3] = pStrand->pixels[i].b;
+        pState->buf_data[0 + i * 3] = (lut[pStrand->pixels[i].g] + bias) >> 8;
+        pState->buf_data[1 + i * 3] = (lut[pStrand->pixels[i].r] + bias) >> 8;
+        pState->buf_data[2 + i * 3] = (lut[pStrand->pixels[i].b] + bias) >> 8;
       }
     }
     else if (ledParams.bytesPerPixel == 4) {
       for (uint16_t i = 0; i < pStrand->numPixels; i++) {
         // Color order is translated from RGBW to GRBW
-        pState->buf_data[0 + i * 4] = pStrand->pixels[i].g;
-        pState->buf_data[1 + i * 4] = pStrand->pixels[i].r;
-        pState->buf_data[2 + i * 4] = pStrand->pixels[i].b;
-        pState->buf_data[3 + i * 4] = pStrand->pixels[i].w;
+        pState->buf_data[0 + i * 4] = (lut[pStrand->pixels[i].g] + bias) >> 8;
+        pState->buf_data[1 + i * 4] = (lut[pStrand->pixels[i].r] + bias) >> 8;
+        pState->buf_data[2 + i * 4] = (lut[pStrand->pixels[i].b] + bias) >> 8;
+        pState->buf_data[3 + i * 4] = (lut[pStrand->pixels[i].w] + bias) >> 8;
       }    
     }
     else {
@@ -311,14 +416,53 @@ int IRAM_ATTR digitalLeds_drawPixels(strand_t * strands [], int numStrands)
     rmt_tx_start(static_cast<rmt_channel_t>(rmtChannel), true);
   }
 
-  // Give back semaphore after drawing is done
-  xSemaphoreTake(gRmtSem, portMAX_DELAY);
+  return 0;
+}
+
+
+int digitalLeds_waitDrawn(uint32_t timeoutMs)
+{
+  TickType_t ticks = (timeoutMs == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+
+  if (xSemaphoreTake(gRmtSem, ticks) != pdTRUE) {
+    return -1;
+  }
   xSemaphoreGive(gRmtSem);
 
   return 0;
 }
 
 
+int digitalLeds_setColorCorrection(strand_t * pStrand, float gamma, bool dither)
+{
+  if (pStrand->_stateVars == nullptr || gamma <= 0.0f) {
+    return -1;
+  }
+
+  digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
+  pState->gamma = gamma;
+  pState->dither = dither;
+  buildColorLut(pStrand);
+
+  return 0;
+}
+
+
+static void buildColorLut(strand_t * pStrand)
+{
+  // Rebuilt only when brightLimit or the gamma changes, never per frame
+  digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
+  int bright = pStrand->brightLimit;
+  uint32_t scale = (bright <= 0 || bright > 255) ? 255 : bright;
+
+  for (int v = 0; v < 256; v++) {
+    float level = (pState->gamma == 1.0f) ? v / 255.0f : powf(v / 255.0f, pState->gamma);
+    pState->colorLut[v] = static_cast<uint16_t>(level * scale * 256.0f + 0.5f);
+  }
+  pState->lut_bright = bright;
+}
+
+
 static IRAM_ATTR void copyHalfBlockToRmt(strand_t * pStrand)
 {
   // This fills half an RMT block
@@ -327,48 +471,57 @@ static IRAM_ATTR void copyHalfBlockToRmt(strand_t * pStrand)
   ledParams_t ledParams = ledParamsAll[pStrand->ledType];
 
   uint16_t i, j, offset, len, byteval;
+  uint16_t halfPulses = pState->half_pulses;
+
+  // A multi-block channel's memory runs on into the following channels' blocks
+  volatile uint32_t * pMem = &RMTMEM.chan[pStrand->rmtChannel].data32[0].val;
 
-  offset = pState->buf_half * MAX_PULSES;
+  offset = pState->buf_half * halfPulses;
   pState->buf_half = !pState->buf_half;
 
   len = pState->buf_len - pState->buf_pos;
-  if (len > (MAX_PULSES / 8))
-    len = (MAX_PULSES / 8);
+  if (len > (halfPulses / 8))
+    len = (halfPulses / 8);
 
   if (!len) {
     if (!pState->buf_isDirty) {
       return;
     }
     // Clear the channel's data block and return
-    for (i = 0; i < MAX_PULSES; i++) {
-      RMTMEM.chan[pStrand->rmtChannel].data32[i + offset].val = 0;
+    for (i = 0; i < halfPulses; i++) {
+      pMem[i + offset] = 0;
     }
     pState->buf_isDirty = 0;
     return;
   }
   pState->buf_isDirty = 1;
 
-  for (i = 0; i < len; i++) {
-    byteval = pState->buf_data[i + pState->buf_pos];
+  volatile uint32_t * pItem = pMem + offset;
+  const uint8_t * pByte = &pState->buf_data[pState->buf_pos];
 
-    // Shift bits out, MSB first, setting RMTMEM.chan[n].data32[x] to
-    // the rmtPulsePair value corresponding to the buffered bit value
-    for (j = 0; j < 8; j++, byteval <<= 1) {
-      int bitval = (byteval >> 7) & 0x01;
-      int data32_idx = i * 8 + offset + j;
-      RMTMEM.chan[pStrand->rmtChannel].data32[data32_idx].val = pState->pulsePairMap[bitval].val;
-    }
+  for (i = 0; i < len; i++, pItem += 8) {
+    byteval = pByte[i];
 
-    // Handle the reset bit by stretching duration1 for the final bit in the stream
-    if (i + pState->buf_pos == pState->buf_len - 1) {
-      RMTMEM.chan[pStrand->rmtChannel].data32[i * 8 + offset + 7].duration1 =
-        ledParams.TRS / (RMT_DURATION_NS * DIVIDER);
+    // Each nibble, MSB first, is four precomputed rmtPulsePair words
+    const rmtPulsePair * hi = pState->nibblePulseMap[byteval >> 4];
+    const rmtPulsePair * lo = pState->nibblePulseMap[byteval & 0x0F];
+    for (j = 0; j < 4; j++) {
+      pItem[j] = hi[j].val;
+      pItem[j + 4] = lo[j].val;
     }
   }
 
+  // Handle the reset bit by stretching duration1 for the final bit in the stream
+  if (pState->buf_pos + len == pState->buf_len) {
+    rmtPulsePair last;
+    last.val = pMem[(len - 1) * 8 + offset + 7];
+    last.duration1 = ledParams.TRS / (RMT_DURATION_NS * DIVIDER);
+    pMem[(len - 1) * 8 + offset + 7] = last.val;
+  }
+
   // Clear the remainder of the channel's data not set above
-  for (i *= 8; i < MAX_PULSES; i++) {
-    RMTMEM.chan[pStrand->rmtChannel].data32[i + offset].val = 0;
+  for (i *= 8; i < halfPulses; i++) {
+    pMem[i + offset] = 0;
   }
   
   pState->buf_pos += len;
@@ -404,6 +557,9 @@ static IRAM_ATTR void rmtInterruptHandler(void *arg)
       pState->isProcessing = false;
       gToProcess--;
       if (gToProcess == 0) {
+        if (gDrawDoneCb != nullptr) {
+          gDrawDoneCb(gDrawDoneArg);
+        }
         xSemaphoreGiveFromISR(gRmtSem, &xHigherPriorityTaskWoken);
         if (xHigherPriorityTaskWoken == pdTRUE) { // Perform cleanup if we're all done
           portYIELD_FROM_ISR();
@@ -35,6 +35,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define DEBUG_ESP32_DIGITAL_LED_LIB 0
 
@@ -69,10 +70,14 @@ typedef struct {
   int rmtChannel;
   int gpioNum;
   int ledType;
-  int brightLimit;
+  int brightLimit;  // Scales every color channel as value * brightLimit / 255, 0 means 255
   int numPixels;
   pixelColor_t * pixels;
   void * _stateVars;
+  int rmtMemBlocks;  // RMT memory blocks (64 pulses each) to use, 1 to 7, 0 means 1; also takes the
+                     // next rmtMemBlocks - 1 channels, but refills interrupt that much less often
+  int nativeOrder;   // Nonzero: no pixels array, the application renders straight into wireBytes
+  uint8_t * wireBytes;  // Transmit buffer in wire order (GRB or GRBW), set by addStrands if nativeOrder
 } strand_t;
 
 typedef struct {
@@ -108,12 +113,58 @@ const ledParams_t ledParamsAll[] = {  // Still must match order of `led_types`
   [LED_SK6812W_V1] = { .bytesPerPixel = 4, .T0H = 300, .T1H = 600, .T0L = 900, .T1L = 600, .TRS =  80000}, // Various, all consistent
 };
 
+// Accessors for nativeOrder strands. The driver sends wireBytes in place, so brightLimit and
+// the color correction are not applied, and a frame must not be rendered until
+// digitalLeds_waitDrawn() says the previous one is off the wire.
+inline void digitalLeds_setPixelNative(strand_t * pStrand, int index, pixelColor_t color)
+{
+  if (ledParamsAll[pStrand->ledType].bytesPerPixel == 4) {
+    uint8_t * p = pStrand->wireBytes + index * 4;
+    p[0] = color.g;
+    p[1] = color.r;
+    p[2] = color.b;
+    p[3] = color.w;
+  }
+  else {
+    uint8_t * p = pStrand->wireBytes + index * 3;
+    p[0] = color.g;
+    p[1] = color.r;
+    p[2] = color.b;
+  }
+}
+
+inline pixelColor_t digitalLeds_getPixelNative(strand_t * pStrand, int index)
+{
+  if (ledParamsAll[pStrand->ledType].bytesPerPixel == 4) {
+    uint8_t * p = pStrand->wireBytes + index * 4;
+    return pixelFromRGBW(p[1], p[0], p[2], p[3]);
+  }
+  uint8_t * p = pStrand->wireBytes + index * 3;
+  return pixelFromRGB(p[1], p[0], p[2]);
+}
+
 extern int digitalLeds_initDriver();
 extern int digitalLeds_addStrands(strand_t * strands [], int numStrands);
 extern int digitalLeds_removeStrands(strand_t * strands [], int numStrands);
 extern int digitalLeds_drawPixels(strand_t * strands [], int numStrands);
 extern int digitalLeds_resetPixels(strand_t * strands [], int numStrands);
 
+// Called from the RMT interrupt once every strand of a frame has been sent
+typedef void (*digitalLeds_drawDoneCb_t)(void * arg);
+
+// Packs the pixels of all strands and starts sending them, without waiting for
+// the wire. Pixels may be rendered into again as soon as this returns; only a
+// previous frame still on the wire is waited for. onDone (may be nullptr) runs
+// in interrupt context and must be IRAM_ATTR.
+extern int digitalLeds_drawPixelsAsync(strand_t * strands [], int numStrands,
+                                       digitalLeds_drawDoneCb_t onDone, void * arg);
+// Waits up to timeoutMs (UINT32_MAX: forever) for the frame in flight; 0 when idle, -1 on timeout
+extern int digitalLeds_waitDrawn(uint32_t timeoutMs);
+
+// Gamma curve applied with brightLimit while pixels are packed, 1.0 (the default) is linear.
+// With dither the fraction lost by rounding to 8 bits is spread over successive frames.
+extern int digitalLeds_setColorCorrection(strand_t * pStrand, float gamma, bool dither);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,13 +55,262 @@
 * 
 */
 
+#ifndef _HEART_RATE_H_
+#define _HEART_RATE_H_
+
 #if (ARDUINO >= 100)
  #include "Arduino.h"
 #else
  #include "WProgram.h"
 #endif
 
+#define HEARTRATE_FIR_TAPS 23 //Length of the built-in low pass filter
+
+//First HEARTRATE_FIR_TAPS / 2 + 1 taps of the symmetric filter, centre tap last, Q15
+extern const uint16_t FIRCoeffs[HEARTRATE_FIR_TAPS / 2 + 1];
+
 bool checkForBeat(int32_t sample);
 int16_t averageDCEstimator(int32_t *p, uint16_t x);
 int16_t lowPassFIRFilter(int16_t din);
 int32_t mul16(int16_t x, int16_t y);
+
+#define HEARTRATE_FIR_BLOCK 32 //Samples filtered per pass, one full MAX30102 FIFO
+
+//  Symmetric low pass FIR on blocks of samples
+//  The delay line is linear: new samples are appended behind the last TAPS - 1
+//  and slid back once per BLOCK samples, so the kernel indexes it directly
+//  instead of masking every tap. Mirrored taps are folded before the multiply,
+//  halving the multiplies. Output is bit-exact with lowPassFIRFilter(),
+//  including its 16 bit wrap of the folded pair.
+//  Coefficients are the first TAPS / 2 + 1 taps, centre tap last, Q15.
+template <uint8_t TAPS = HEARTRATE_FIR_TAPS, uint8_t BLOCK = HEARTRATE_FIR_BLOCK>
+class SymmetricFIR
+{
+  static_assert(TAPS % 2 == 1 && TAPS < 128, "SymmetricFIR needs an odd filter length below 128");
+  static_assert(BLOCK > 0 && TAPS - 1 + BLOCK < 256, "SymmetricFIR delay line must fit 255 samples");
+
+public:
+  SymmetricFIR() : coeffs(FIRCoeffs)
+  {
+    static_assert(TAPS == HEARTRATE_FIR_TAPS, "The built-in coefficients are for HEARTRATE_FIR_TAPS, pass your own");
+    reset();
+  }
+
+  explicit SymmetricFIR(const uint16_t *firCoeffs) : coeffs(firCoeffs)
+  {
+    reset();
+  }
+
+  void reset(void)
+  {
+    memset(line, 0, sizeof(line));
+    fill = TAPS - 1;
+  }
+
+  //  Filter n samples; in and out may be the same buffer
+  void process(const int16_t *in, int16_t *out, uint16_t n)
+  {
+    while (n > 0)
+    {
+      if (fill == TAPS - 1 + BLOCK)
+      {
+        //Slide the history back to the front
+        memmove(line, line + BLOCK, (TAPS - 1) * sizeof(int16_t));
+        fill = TAPS - 1;
+      }
+
+      uint16_t count = TAPS - 1 + BLOCK - fill;
+      if (count > n)
+        count = n;
+      memcpy(line + fill, in, count * sizeof(int16_t));
+      kernel(line + fill - (TAPS - 1), out, count);
+
+      fill += count;
+      in += count;
+      out += count;
+      n -= count;
+    }
+  }
+
+  int16_t process(int16_t din)
+  {
+    int16_t dout;
+
+    process(&din, &dout, 1);
+    return(dout);
+  }
+
+private:
+  //  x[0] is the oldest sample of the first window, x[TAPS - 1] the newest
+  void kernel(const int16_t *x, int16_t *y, uint16_t count)
+  {
+    const uint8_t half = TAPS / 2;
+
+    for (uint16_t k = 0; k < count; k++, x++)
+    {
+      int32_t z = (int32_t)(int16_t)coeffs[half] * x[half];
+
+      for (uint8_t i = 0; i < half; i++)
+        z += (int32_t)(int16_t)coeffs[i] * (int16_t)(x[TAPS - 1 - i] + x[i]);
+
+      y[k] = z >> 15;
+    }
+  }
+
+  const uint16_t *coeffs;
+  int16_t line[TAPS - 1 + BLOCK];
+  uint8_t fill; //Where the next sample goes
+};
+
+//  Beat detector for one PPG channel (PBA algorithm, as checkForBeat())
+//  All state lives in the object, so red and IR, or several sensors, can be
+//  tracked at the same time, each from its own task.
+//  TAPS is the length of the symmetric low pass FIR. The built-in
+//  coefficients are for HEARTRATE_FIR_TAPS; other lengths pass their own
+//  TAPS / 2 + 1 Q15 coefficients, centre tap last.
+template <uint8_t TAPS = HEARTRATE_FIR_TAPS>
+class BeatDetector
+{
+public:
+  BeatDetector()
+  {
+    reset();
+  }
+
+  explicit BeatDetector(const uint16_t *firCoeffs) : fir(firCoeffs)
+  {
+    reset();
+  }
+
+  void reset(void)
+  {
+    fir.reset();
+    dcReg = 0;
+    dcEstimate = 0;
+    acMax = 20;
+    acMin = -20;
+    acCurrent = 0;
+    acPrevious = 0;
+    acSignalMin = 0;
+    acSignalMax = 0;
+    positiveEdge = 0;
+    negativeEdge = 0;
+  }
+
+  //  Takes one sample, returns true if a beat is detected
+  bool check(int32_t sample)
+  {
+    //  Process next data sample
+    dcEstimate = averageDCEstimator(&dcReg, sample);
+    return(detect(fir.process((int16_t)(sample - dcEstimate))));
+  }
+
+  //  Takes a block of samples, returns the number of beats. If beats is
+  //  given, the indices of up to maxBeats of them are stored there.
+  //  The DC estimate and the filter run over whole blocks, so a 32 sample
+  //  FIFO drain is a single filter pass.
+  uint16_t process(const int32_t *samples, uint16_t n, uint16_t *beats = NULL, uint16_t maxBeats = 0)
+  {
+    int16_t ac[HEARTRATE_FIR_BLOCK];
+    uint16_t found = 0;
+
+    for (uint16_t done = 0; done < n; )
+    {
+      uint16_t count = n - done;
+      if (count > HEARTRATE_FIR_BLOCK)
+        count = HEARTRATE_FIR_BLOCK;
+
+      for (uint16_t i = 0; i < count; i++)
+      {
+        dcEstimate = averageDCEstimator(&dcReg, samples[done + i]);
+        ac[i] = samples[done + i] - dcEstimate;
+      }
+      fir.process(ac, ac, count);
+
+      for (uint16_t i = 0; i < count; i++)
+      {
+        if (detect(ac[i]))
+        {
+          if (beats != NULL && found < maxBeats)
+            beats[found] = done + i;
+          found++;
+        }
+      }
+      done += count;
+    }
+    return(found);
+  }
+
+  //  Low Pass FIR Filter
+  int16_t filter(int16_t din) { return(fir.process(din)); }
+
+  int16_t getAC(void) { return(acCurrent); } //Filtered signal, for plotting
+  int16_t getDC(void) { return(dcEstimate); }
+
+private:
+  //  Zero crossing and amplitude tracking on the filtered signal
+  bool detect(int16_t ac)
+  {
+    bool beatDetected = false;
+
+    //  Save current state
+    acPrevious = acCurrent;
+    acCurrent = ac;
+
+    //  Detect positive zero crossing (rising edge)
+    if ((acPrevious < 0) & (acCurrent >= 0))
+    {
+      acMax = acSignalMax; //Adjust our AC max and min
+      acMin = acSignalMin;
+
+      positiveEdge = 1;
+      negativeEdge = 0;
+      acSignalMax = 0;
+
+      if (((acMax - acMin) > 20) & ((acMax - acMin) < 1000))
+      {
+        //Heart beat!!!
+        beatDetected = true;
+      }
+    }
+
+    //  Detect negative zero crossing (falling edge)
+    if ((acPrevious > 0) & (acCurrent <= 0))
+    {
+      positiveEdge = 0;
+      negativeEdge = 1;
+      acSignalMin = 0;
+    }
+
+    //  Find Maximum value in positive cycle
+    if (positiveEdge & (acCurrent > acPrevious))
+    {
+      acSignalMax = acCurrent;
+    }
+
+    //  Find Minimum value in negative cycle
+    if (negativeEdge & (acCurrent < acPrevious))
+    {
+      acSignalMin = acCurrent;
+    }
+
+    return(beatDetected);
+  }
+
+  SymmetricFIR<TAPS> fir;
+
+  int32_t dcReg;
+  int16_t dcEstimate;
+
+  int16_t acMax;
+  int16_t acMin;
+  int16_t acCurrent;
+  int16_t acPrevious;
+  int16_t acSignalMin;
+  int16_t acSignalMax;
+
+  int16_t positiveEdge;
+  int16_t negativeEdge;
+};
+
+#endif
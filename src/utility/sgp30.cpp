@@ -10,9 +10,7 @@ uint8_t sgp30::SGP30_I2c_Write_Cmd(uint16_t cmd_val)
 	uint8_t cmd[2];
 	cmd[0] = cmd_val >> 8;
 	cmd[1] = cmd_val;
-	Wire.beginTransmission(SGP30_ADDR);
-  Wire.write(cmd,2);
-    if((Wire.endTransmission()))
+    if(!i2c.write(cmd, 2))
     {	
     	Serial.println("end error");
     	return 1;
@@ -28,13 +26,7 @@ uint8_t sgp30::SGP30_I2c_Write_Cmd(uint16_t cmd_val)
   */
 void sgp30::SGP30_I2c_Read(uint8_t len, uint8_t *data_buf)
 {
-	
-	int i=0;
-	Wire.requestFrom(SGP30_ADDR, len);
-	while(i<len)
-	{
-		data_buf[i++]=Wire.read();
-	}
+	i2c.read(data_buf, len);
 }
 
 /**
@@ -44,9 +36,8 @@ void sgp30::SGP30_I2c_Read(uint8_t len, uint8_t *data_buf)
   */
 uint8_t sgp30::SGP30_Soft_Reset()
 {
-	Wire.beginTransmission(SGP30_ADDR);
-    Wire.write(SGP30_SOFT_RESET_CMD);
-    if((Wire.endTransmission()))
+	uint8_t cmd = SGP30_SOFT_RESET_CMD;
+    if(!i2c.write(&cmd, 1))
     {	
     	Serial.println("end error");
     	return 1;
@@ -102,20 +93,47 @@ uint8_t sgp30::CheckCrc8(uint8_t* const message, uint8_t initial_value)
 }
 
 /**
-  * @brief  Collect data
+  * @brief  Collect data, blocks for the measurement time only.
+            The sensor expects one measurement per second.
   * @param  void
   * @retval success:return 0; failed:return 1
   */
 uint8_t sgp30::SGP30_Get_Value()
 {
-    uint8_t recv_buf[6]={0,0,0,0,0,0};
+    if(SGP30_Start_Measure())
+        return 1;
+
+    i2c.wait(&xfer);
+    return SGP30_Collect();
+}
+
+/**
+  * @brief  Start a measurement without blocking; the bus task sends the
+            command and fetches the result SGP30_MEASURE_TIME_US later
+  * @param  void
+  * @retval success:return 0; failed:return 1
+  */
+uint8_t sgp30::SGP30_Start_Measure(void)
+{
+    uint8_t cmd[2] = { SGP30_MEASURE_AIR_QUALITY >> 8, SGP30_MEASURE_AIR_QUALITY & 0xFF };
+    I2C_STATS_XFER_SITE(&xfer, "SGP30_Start_Measure");
 
-    if(SGP30_I2c_Write_Cmd(SGP30_MEASURE_AIR_QUALITY))
+    if(!i2c.submit(&xfer, cmd, 2, recv_buf, 6, SGP30_MEASURE_TIME_US))
         return 1;
-    
-    delay(1000);
+    return 0;
+}
 
-    SGP30_I2c_Read(6, recv_buf);
+/**
+  * @brief  Check and store the result of SGP30_Start_Measure
+  * @param  void
+  * @retval success:return 0; failed:return 1; still measuring:return 2
+  */
+uint8_t sgp30::SGP30_Collect(void)
+{
+    if(xfer.pending())
+        return 2;
+    if(!xfer.done())
+        return 1;
 
     if (CheckCrc8(&recv_buf[0], 0xFF) != recv_buf[2])
         return 1;
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "I2CBus.h"
 
 #define SGP30_ADDR                  0x58          //IIC correspondence address of SGP30
 
@@ -10,20 +11,29 @@
 #define SGP30_INIT_AIR_QUALITY      0x2003        
 #define SGP30_MEASURE_AIR_QUALITY   0x2008        
 #define SGP30_CRC8_POLYNOMIAL       0x31
+#define SGP30_MEASURE_TIME_US       12000         //Max duration of Measure_air_quality
 
 class sgp30{
 	public:
+		sgp30() : co2_val(0), tvoc_val(0), i2c(SGP30_ADDR) {}
+		void setBus(I2CBus& bus, uint32_t clock = 0) { i2c.setBus(bus); i2c.setClock(clock); }
 		uint8_t SGP30_I2c_Write_Cmd(uint16_t cmd_val);
 		void SGP30_I2c_Read(uint8_t len, uint8_t *data_buf);
 		uint8_t SGP30_Soft_Reset(void);
 		uint8_t SGP30_Init(void);
 		uint8_t CheckCrc8(uint8_t* const message, uint8_t initial_value);
 		uint8_t SGP30_Get_Value();
+		uint8_t SGP30_Start_Measure(void);
+		bool SGP30_Measure_Busy(void) { return xfer.pending(); }
+		uint8_t SGP30_Collect(void);
 		uint16_t get_co2_val();
 		uint16_t get_tvoc_val();
 
 	private:
 		uint16_t co2_val, tvoc_val;
+		I2CDevice i2c;
+		I2CTransfer xfer;
+		uint8_t recv_buf[6];
 };
 
 #endif 
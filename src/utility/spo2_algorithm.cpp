@@ -60,6 +60,20 @@
 #include "Arduino.h"
 #include "spo2_algorithm.h"
 
+const uint8_t uch_spo2_table[184]={ 95, 95, 95, 96, 96, 96, 97, 97, 97, 97, 97, 98, 98, 98, 98, 98, 99, 99, 99, 99, 
+              99, 99, 99, 99, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 
+              100, 100, 100, 100, 99, 99, 99, 99, 99, 99, 99, 99, 98, 98, 98, 98, 98, 98, 97, 97, 
+              97, 97, 96, 96, 96, 96, 95, 95, 95, 94, 94, 94, 93, 93, 93, 92, 92, 92, 91, 91, 
+              90, 90, 89, 89, 89, 88, 88, 87, 87, 86, 86, 85, 85, 84, 84, 83, 82, 82, 81, 81, 
+              80, 80, 79, 78, 78, 77, 76, 76, 75, 74, 74, 73, 72, 72, 71, 70, 69, 69, 68, 67, 
+              66, 66, 65, 64, 63, 62, 62, 61, 60, 59, 58, 57, 56, 56, 55, 54, 53, 52, 51, 50, 
+              49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 31, 30, 29, 
+              28, 27, 26, 25, 23, 22, 21, 20, 19, 17, 16, 15, 14, 12, 11, 10, 9, 7, 6, 5, 
+              3, 2, 1 } ;
+
+static  int32_t an_x[ BUFFER_SIZE]; //ir
+static  int32_t an_y[ BUFFER_SIZE]; //red
+
 #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
 //Arduino Uno doesn't have enough SRAM to store 100 samples of IR led data and red led data in 32-bit format
 //To solve this problem, 16-bit MSB of the sampled data will be truncated.  Samples become 16-bit data.
@@ -207,6 +221,207 @@ void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer, int32_t n_i
 }
 
 
+#define SPO2_DC_SHIFT 5             // running DC over ~32 samples
+#define SPO2_MIN_DISTANCE 4         // same peak distance as the batch algorithm
+#define SPO2_WARMUP (FreqS)         // let the DC settle before looking for valleys
+
+void maxim_spo2_init(maxim_spo2_state_t *ps_state)
+/**
+* \brief        Reset the streaming estimator
+* \par          Details
+*               Call once before the first maxim_spo2_update(), and again whenever the finger was lifted.
+*
+* \param[out]   *ps_state               - Estimator state
+*
+* \retval       None
+*/
+{
+  memset(ps_state, 0, sizeof(*ps_state));
+  ps_state->n_spo2 = -999;
+  ps_state->n_heart_rate = -999;
+}
+
+static int32_t maxim_spo2_beat_ratio(maxim_spo2_state_t *ps_state, uint32_t un_start, uint32_t un_end)
+/**
+* \brief        Red/IR AC/DC ratio of one beat
+* \par          Details
+*               Same ratio as the batch algorithm: per channel, the maximum between two IR valleys minus the
+*               straight line through the valleys, over the maximum. Returns -1 if it can not be computed.
+*/
+{
+  int32_t n_x_dc_max = -16777216, n_y_dc_max = -16777216;
+  uint32_t un_x_dc_max_idx = un_start, un_y_dc_max_idx = un_start;
+  int32_t n_len = un_end - un_start;
+  const uint32_t un_mask = SPO2_HISTORY_SIZE - 1;
+
+  for (uint32_t i = un_start; i < un_end; i++){
+    int32_t n_x = ps_state->aun_ir_hist[i & un_mask];
+    int32_t n_y = ps_state->aun_red_hist[i & un_mask];
+    if (n_x > n_x_dc_max) {n_x_dc_max = n_x; un_x_dc_max_idx = i;}
+    if (n_y > n_y_dc_max) {n_y_dc_max = n_y; un_y_dc_max_idx = i;}
+  }
+
+  int32_t n_x0 = ps_state->aun_ir_hist[un_start & un_mask], n_x1 = ps_state->aun_ir_hist[un_end & un_mask];
+  int32_t n_y0 = ps_state->aun_red_hist[un_start & un_mask], n_y1 = ps_state->aun_red_hist[un_end & un_mask];
+  int32_t n_x_ac = n_x_dc_max - (n_x0 + (n_x1 - n_x0) * (int32_t)(un_x_dc_max_idx - un_start) / n_len);
+  int32_t n_y_ac = n_y_dc_max - (n_y0 + (n_y1 - n_y0) * (int32_t)(un_y_dc_max_idx - un_start) / n_len);
+  int64_t n_nume = ((int64_t)n_y_ac * n_x_dc_max) >> 7;
+  int64_t n_denom = ((int64_t)n_x_ac * n_y_dc_max) >> 7;
+
+  if (n_denom <= 0 || n_nume == 0)
+    return -1;
+  return (int32_t)((n_nume * 100) / n_denom);
+}
+
+static int8_t maxim_spo2_valley(maxim_spo2_state_t *ps_state, uint32_t un_valley)
+/**
+* \brief        A valley is confirmed: close the beat that started at the previous one
+*
+* \retval       1 if a beat was completed
+*/
+{
+  uint32_t un_prev = ps_state->un_valley_idx;
+  int8_t ch_had_valley = ps_state->ch_valley_valid;
+
+  ps_state->un_valley_idx = un_valley;
+  ps_state->ch_valley_valid = 1;
+  if (!ch_had_valley)
+    return 0;
+
+  int32_t n_len = un_valley - un_prev;
+  // The beat has to still be in the history; longer gaps are dropouts, not beats
+  if (n_len <= 3 || ps_state->un_count - un_prev > SPO2_HISTORY_SIZE)
+    return 0;
+
+  // Heart rate: mean of the last SPO2_HR_AVG_SIZE intervals
+  if (ps_state->uch_interval_count == SPO2_HR_AVG_SIZE)
+    ps_state->n_interval_sum -= ps_state->an_interval[ps_state->uch_interval_pos];
+  else
+    ps_state->uch_interval_count++;
+  ps_state->an_interval[ps_state->uch_interval_pos] = n_len;
+  ps_state->n_interval_sum += n_len;
+  ps_state->uch_interval_pos = (ps_state->uch_interval_pos + 1) % SPO2_HR_AVG_SIZE;
+  ps_state->n_heart_rate = (FreqS * 60 * ps_state->uch_interval_count) / ps_state->n_interval_sum;
+  ps_state->ch_hr_valid = 1;
+
+  // SpO2: median of the last SPO2_RATIO_SIZE beat ratios, picked like the batch algorithm
+  int32_t n_ratio = maxim_spo2_beat_ratio(ps_state, un_prev, un_valley);
+  if (n_ratio >= 0){
+    ps_state->an_ratio[ps_state->uch_ratio_pos] = n_ratio;
+    ps_state->uch_ratio_pos = (ps_state->uch_ratio_pos + 1) % SPO2_RATIO_SIZE;
+    if (ps_state->uch_ratio_count < SPO2_RATIO_SIZE)
+      ps_state->uch_ratio_count++;
+  }
+  if (ps_state->uch_ratio_count > 0){
+    int32_t an_sorted[SPO2_RATIO_SIZE];
+    int32_t n_middle_idx = ps_state->uch_ratio_count / 2;
+    int32_t n_ratio_average;
+
+    memcpy(an_sorted, ps_state->an_ratio, ps_state->uch_ratio_count * sizeof(int32_t));
+    maxim_sort_ascend(an_sorted, ps_state->uch_ratio_count);
+    if (n_middle_idx > 1)
+      n_ratio_average = (an_sorted[n_middle_idx - 1] + an_sorted[n_middle_idx]) / 2;
+    else
+      n_ratio_average = an_sorted[n_middle_idx];
+
+    if (n_ratio_average > 2 && n_ratio_average < 184){
+      ps_state->n_spo2 = uch_spo2_table[n_ratio_average];
+      ps_state->ch_spo2_valid = 1;
+    }
+    else{
+      ps_state->n_spo2 = -999;
+      ps_state->ch_spo2_valid = 0;
+    }
+  }
+  return 1;
+}
+
+int8_t maxim_spo2_update(maxim_spo2_state_t *ps_state, uint32_t un_ir, uint32_t un_red, int32_t *pn_spo2, int8_t *pch_spo2_valid,
+                int32_t *pn_heart_rate, int8_t *pch_hr_valid)
+/**
+* \brief        Feed one sample to the streaming heart rate/SpO2 estimator
+* \par          Details
+*               Incremental version of maxim_heart_rate_and_oxygen_saturation(): a running DC level replaces the window
+*               mean, IR valleys are found online on the 4 pt moving average, and each completed beat updates HR
+*               and SpO2 right away. Constant work per sample plus one scan of the finished beat, no 100 sample window.
+*               Samples must arrive at FreqS.
+*
+* \param[in,out] *ps_state              - Estimator state, see maxim_spo2_init()
+* \param[in]    un_ir                   - IR sample
+* \param[in]    un_red                  - Red sample
+* \param[out]    *pn_spo2                - Latest SpO2 value
+* \param[out]    *pch_spo2_valid         - 1 if the SpO2 value is valid
+* \param[out]    *pn_heart_rate          - Latest heart rate value
+* \param[out]    *pch_hr_valid           - 1 if the heart rate value is valid
+*
+* \retval       1 if this sample completed a beat and the outputs were updated
+*/
+{
+  uint32_t un_idx = ps_state->un_count;
+  int8_t ch_beat = 0;
+
+  ps_state->aun_ir_hist[un_idx & (SPO2_HISTORY_SIZE - 1)] = un_ir;
+  ps_state->aun_red_hist[un_idx & (SPO2_HISTORY_SIZE - 1)] = un_red;
+  ps_state->un_count++;
+
+  // remove DC and invert signal so that we can use peak detector as valley detector
+  if (un_idx == 0)
+    ps_state->n_ir_dc = (int32_t)un_ir << 8;
+  else
+    ps_state->n_ir_dc += (((int32_t)un_ir << 8) - ps_state->n_ir_dc) >> SPO2_DC_SHIFT;
+  int32_t n_x = (ps_state->n_ir_dc >> 8) - (int32_t)un_ir;
+
+  // 4 pt Moving Average
+  ps_state->n_ma_sum += n_x - ps_state->an_ma[un_idx % MA4_SIZE];
+  ps_state->an_ma[un_idx % MA4_SIZE] = n_x;
+  n_x = ps_state->n_ma_sum / MA4_SIZE;
+  ps_state->n_x_mean += ((n_x << 8) - ps_state->n_x_mean) >> SPO2_DC_SHIFT;
+
+  if (un_idx >= SPO2_WARMUP){
+    int32_t n_th1 = ps_state->n_x_mean >> 8;
+    if (n_th1 < 30) n_th1 = 30; // min allowed
+    if (n_th1 > 60) n_th1 = 60; // max allowed
+
+    // find peaks; for flat peaks, peak location is left edge
+    if (n_x > ps_state->n_x_prev){
+      ps_state->ch_rising = 1;
+      ps_state->n_top = n_x;
+      ps_state->un_top_idx = un_idx;
+    }
+    else if (n_x < ps_state->n_x_prev && ps_state->ch_rising){
+      ps_state->ch_rising = 0;
+      if (ps_state->n_top > n_th1){
+        // of peaks closer than SPO2_MIN_DISTANCE only the highest is kept
+        if (ps_state->ch_cand_valid && ps_state->un_top_idx - ps_state->un_cand_idx <= SPO2_MIN_DISTANCE){
+          if (ps_state->n_top > ps_state->n_cand){
+            ps_state->n_cand = ps_state->n_top;
+            ps_state->un_cand_idx = ps_state->un_top_idx;
+          }
+        }
+        else if (!ps_state->ch_valley_valid || ps_state->un_top_idx - (ps_state->un_valley_idx + MA4_SIZE / 2) > SPO2_MIN_DISTANCE){
+          ps_state->ch_cand_valid = 1;
+          ps_state->n_cand = ps_state->n_top;
+          ps_state->un_cand_idx = ps_state->un_top_idx;
+        }
+      }
+    }
+
+    // nothing higher within the peak distance: the candidate is a valley of the raw IR,
+    // centered in the moving average window
+    if (ps_state->ch_cand_valid && un_idx - ps_state->un_cand_idx > SPO2_MIN_DISTANCE){
+      ps_state->ch_cand_valid = 0;
+      ch_beat = maxim_spo2_valley(ps_state, ps_state->un_cand_idx - MA4_SIZE / 2);
+    }
+  }
+  ps_state->n_x_prev = n_x;
+
+  *pn_spo2 = ps_state->ch_spo2_valid ? ps_state->n_spo2 : -999;
+  *pch_spo2_valid = ps_state->ch_spo2_valid;
+  *pn_heart_rate = ps_state->ch_hr_valid ? ps_state->n_heart_rate : -999;
+  *pch_hr_valid = ps_state->ch_hr_valid;
+  return ch_beat;
+}
+
 void maxim_find_peaks( int32_t *pn_locs, int32_t *n_npks,  int32_t  *pn_x, int32_t n_size, int32_t n_min_height, int32_t n_min_distance, int32_t n_max_num )
 /**
 * \brief        Find peaks
@@ -70,18 +70,43 @@
 //#define min(x,y) ((x) < (y) ? (x) : (y)) //Defined in Arduino.h
 
 //uch_spo2_table is approximated as  -45.060*ratioAverage* ratioAverage + 30.354 *ratioAverage + 94.845 ;
-const uint8_t uch_spo2_table[184]={ 95, 95, 95, 96, 96, 96, 97, 97, 97, 97, 97, 98, 98, 98, 98, 98, 99, 99, 99, 99, 
-              99, 99, 99, 99, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 
-              100, 100, 100, 100, 99, 99, 99, 99, 99, 99, 99, 99, 98, 98, 98, 98, 98, 98, 97, 97, 
-              97, 97, 96, 96, 96, 96, 95, 95, 95, 94, 94, 94, 93, 93, 93, 92, 92, 92, 91, 91, 
-              90, 90, 89, 89, 89, 88, 88, 87, 87, 86, 86, 85, 85, 84, 84, 83, 82, 82, 81, 81, 
-              80, 80, 79, 78, 78, 77, 76, 76, 75, 74, 74, 73, 72, 72, 71, 70, 69, 69, 68, 67, 
-              66, 66, 65, 64, 63, 62, 62, 61, 60, 59, 58, 57, 56, 56, 55, 54, 53, 52, 51, 50, 
-              49, 48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 31, 30, 29, 
-              28, 27, 26, 25, 23, 22, 21, 20, 19, 17, 16, 15, 14, 12, 11, 10, 9, 7, 6, 5, 
-              3, 2, 1 } ;
-static  int32_t an_x[ BUFFER_SIZE]; //ir
-static  int32_t an_y[ BUFFER_SIZE]; //red
+extern const uint8_t uch_spo2_table[184];
+
+#define SPO2_HISTORY_SIZE 64  // raw samples kept by the streaming estimator, must be a power of two; bounds the longest beat (~2.3 s at FreqS)
+#define SPO2_HR_AVG_SIZE 4    // beat intervals averaged for the heart rate
+#define SPO2_RATIO_SIZE 5     // per-beat ratios the SpO2 median is taken over
+
+/**
+* \brief        State of the streaming estimator, one per sensor
+* \par          Details
+*               Everything maxim_spo2_update() needs between samples. Initialize with maxim_spo2_init().
+*/
+typedef struct
+{
+  uint32_t un_count;                          // samples seen
+  int32_t n_ir_dc;                            // running IR DC level, Q8
+  int32_t n_x_mean;                           // running mean of the AC signal, Q8; the valley threshold
+  int32_t an_ma[MA4_SIZE];                    // DC removed, inverted IR for the 4 pt moving average
+  int32_t n_ma_sum;
+  int32_t n_x_prev;                           // previous moving average output
+  int8_t ch_rising;
+  int32_t n_top;                              // top of the current rising edge
+  uint32_t un_top_idx;
+  int8_t ch_cand_valid;                       // best valley so far, confirmed once nothing deeper follows within the peak distance
+  int32_t n_cand;
+  uint32_t un_cand_idx;
+  int8_t ch_valley_valid;                     // last confirmed valley
+  uint32_t un_valley_idx;
+  uint32_t aun_ir_hist[SPO2_HISTORY_SIZE];    // raw samples for the per-beat AC/DC ratio
+  uint32_t aun_red_hist[SPO2_HISTORY_SIZE];
+  int32_t an_interval[SPO2_HR_AVG_SIZE];
+  int32_t n_interval_sum;
+  uint8_t uch_interval_count, uch_interval_pos;
+  int32_t an_ratio[SPO2_RATIO_SIZE];
+  uint8_t uch_ratio_count, uch_ratio_pos;
+  int32_t n_spo2, n_heart_rate;
+  int8_t ch_spo2_valid, ch_hr_valid;
+} maxim_spo2_state_t;
 
 
 #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
@@ -92,6 +117,9 @@ void maxim_heart_rate_and_oxygen_saturation(uint16_t *pun_ir_buffer, int32_t n_i
 void maxim_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer, int32_t n_ir_buffer_length, uint32_t *pun_red_buffer, int32_t *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid);
 #endif
 
+void maxim_spo2_init(maxim_spo2_state_t *ps_state);
+int8_t maxim_spo2_update(maxim_spo2_state_t *ps_state, uint32_t un_ir, uint32_t un_red, int32_t *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid);
+
 void maxim_find_peaks(int32_t *pn_locs, int32_t *n_npks,  int32_t  *pn_x, int32_t n_size, int32_t n_min_height, int32_t n_min_distance, int32_t n_max_num);
 void maxim_peaks_above_min_height(int32_t *pn_locs, int32_t *n_npks,  int32_t  *pn_x, int32_t n_size, int32_t n_min_height);
 void maxim_remove_close_peaks(int32_t *pn_locs, int32_t *pn_npks, int32_t *pn_x, int32_t n_min_distance);
@@ -32,10 +32,7 @@
 */
 void TCS34725::write8 (uint8_t reg, uint32_t value)
 {
-  Wire.beginTransmission(TCS34725_ADDRESS);
-  Wire.write(TCS34725_COMMAND_BIT | reg);
-   Wire.write(value);
-  if((Wire.endTransmission()))
+  if(!_i2c.writeReg(TCS34725_COMMAND_BIT | reg, value))
     Serial.println("end error");
 }
 
@@ -47,13 +44,8 @@ void TCS34725::write8 (uint8_t reg, uint32_t value)
 uint8_t TCS34725::read8(uint8_t reg)
 {
   uint8_t temp=-2;
-  Wire.beginTransmission(TCS34725_ADDRESS);
-  Wire.write(TCS34725_COMMAND_BIT | reg);
-
-  if(Wire.endTransmission())
+  if(!_i2c.readReg(TCS34725_COMMAND_BIT | reg, &temp))
     Serial.println("end error");
-  Wire.requestFrom(TCS34725_ADDRESS, 1);
-  temp=Wire.read();
   return temp;
 }
 
@@ -64,18 +56,10 @@ uint8_t TCS34725::read8(uint8_t reg)
 */
 uint16_t TCS34725::read16(uint8_t reg)
 {
-  uint16_t x; uint16_t t;
-
-  Wire.beginTransmission(TCS34725_ADDRESS);
-  Wire.write(TCS34725_COMMAND_BIT | reg);
-  Wire.endTransmission();
-
-  Wire.requestFrom(TCS34725_ADDRESS, 2);
-  t = Wire.read();
-  x = Wire.read();
-  x <<= 8;
-  x |= t;
-  return x;
+  uint8_t buf[2] = {0, 0};
+
+  _i2c.readRegs(TCS34725_COMMAND_BIT | reg, buf, 2);
+  return (uint16_t)buf[1] << 8 | buf[0];
 }
 
 /*
@@ -110,6 +94,7 @@ void TCS34725::disable(void)
   * @retval none
 */
 TCS34725::TCS34725(tcs34725IntegrationTime_t it, tcs34725Gain_t gain) 
+  : _i2c(TCS34725_ADDRESS)
 {
   _tcs34725Initialised = false;
   _tcs34725IntegrationTime = it;
@@ -201,10 +186,13 @@ void TCS34725::getRawData (uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c)
 {
   if (!_tcs34725Initialised) begin();
 
-  *c = read16(TCS34725_CDATAL);
-  *r = read16(TCS34725_RDATAL);
-  *g = read16(TCS34725_GDATAL);
-  *b = read16(TCS34725_BDATAL);
+  {
+    I2C_STATS_SITE(_i2c.getBus(), "TCS34725::getRawData");
+    *c = read16(TCS34725_CDATAL);
+    *r = read16(TCS34725_RDATAL);
+    *g = read16(TCS34725_GDATAL);
+    *b = read16(TCS34725_BDATAL);
+  }
   
   /* Set a delay for the integration time */
   switch (_tcs34725IntegrationTime)
@@ -37,6 +37,7 @@
 #include <Arduino.h>
 
 #include <Wire.h>
+#include "I2CBus.h"
 
 #define TCS34725_ADDRESS          (0x29)
 
@@ -114,6 +115,7 @@ class TCS34725 {
   TCS34725(tcs34725IntegrationTime_t = TCS34725_INTEGRATIONTIME_2_4MS, tcs34725Gain_t = TCS34725_GAIN_1X);                //集成时间默认是2.4ms - 1 cycle， 增益默认是0
   
   boolean  begin(void);
+  void     setBus(I2CBus& bus, uint32_t clock = 0) { _i2c.setBus(bus); _i2c.setClock(clock); }
   void     setIntegrationTime(tcs34725IntegrationTime_t it);
   void     setGain(tcs34725Gain_t gain);
   void     getRawData(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
@@ -128,6 +130,7 @@ class TCS34725 {
   boolean _tcs34725Initialised;
   tcs34725Gain_t _tcs34725Gain;
   tcs34725IntegrationTime_t _tcs34725IntegrationTime; 
+  I2CDevice _i2c;
   
   
 };